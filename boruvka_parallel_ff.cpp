@@ -3,8 +3,15 @@
 
 #include <iostream>
 #include <thread>
-#include "lib/components.hpp"
 #include "lib/dset.hpp"
+#include "lib/graph.hpp"
+#include "lib/utils.hpp"
+#include "lib/utimer.hpp"
+#include "lib/options.hpp"
+#include "lib/relabel.hpp"
+#include "lib/minima.hpp"
+#include "lib/filter_kruskal.hpp"
+#include "lib/mst.hpp"
 #include <ff/ff.hpp>
 #include <ff/farm.hpp>
 #include <ff/parallel_for.hpp>
@@ -13,8 +20,8 @@
 int main(int argc, char *argv[]) {
 
     // Setting up initial stage
-    if (argc != 6) {
-        std::cout << "Usage ./[executable] nw number_nodes number_edges filename iters" << std::endl;
+    if (argc < 6) {
+        std::cout << "Usage ./[executable] nw number_nodes number_edges filename iters [key=value ...]" << std::endl;
         return (0);
     }
 
@@ -28,6 +35,8 @@ int main(int argc, char *argv[]) {
 
     int iters = std::atoi(argv[5]);
 
+    Options options(argc, argv, 6);
+
     long loading_time = 0;
 
     Graph graph;// = Graph();
@@ -36,23 +45,40 @@ int main(int argc, char *argv[]) {
 
         Utimer read_time("loading graph",&loading_time);
 
-        // UNCOMMENT FOR V_E and sc-rel9
         if (filename.empty()) {
-            graph.generateGraph(num_nodes, num_edges);
+            graph.generateGraph(num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_generator(filename)) {
+            graph.generateGraph(filename, num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_snapshot(filename)) {
+            graph.loadSnapshot(filename);
         }
         else {
-            graph.loadGraph(filename);
+            graph.loadGraph(filename, options.get("format", ""), options.getLong("seed", 1), options.get("jitter", "0") != "0");
         }
-        // UNCOMMENT FOR soc-youtube
-        // graph.loadGraphUnweighted(filename);
 
     }
 
     std::cout << "fastflow; read time: " << loading_time << " usec" << std::endl;
 
-    Graph copy_graph = graph;
+    if (options.has("save")) {
+        graph.saveSnapshot(options.get("save"));
+        std::cout << "snapshot saved to " << options.get("save") << std::endl;
+    }
+
+    // The loaded graph is never modified: every run works on a view of it, whose buffers are reused by the next runs
+    GraphView view (graph);
+
+    MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
 
-    MyEdge NULL_CONN = {0,0,10};
+    // Minimum edge selection: per worker copies merged afterwards (merge) or a shared array updated with a packed write-min (atomic)
+    bool atomic_min = options.get("min", "merge") == "atomic";
+
+    PackedMinima packed_minima (atomic_min ? graph.originalNodes : 0);
+
+    // MST engine: the Boruvka rounds or Filter-Kruskal (whose workers are plain threads, not the ParallelFor)
+    bool filter_kruskal = options.get("engine", "boruvka") == "filterkruskal";
 
     for (int nw = 1; nw <= num_w; nw++) {
 
@@ -60,24 +86,58 @@ int main(int argc, char *argv[]) {
         ff::ParallelFor pf(nw);
 
         while (iters > 0) {
+
+            view.reset();
         
             // Disjoint Union Find structure
-            DisjointSets initialComponents = { static_cast<uint32_t>(graph.getNumNodes()) };
+            DisjointSets initialComponents = { static_cast<uint32_t>(view.originalNodes) };
+
+            // Edges added to the spanning tree by each worker
+            MSTRecorder recorder;
+
+            recorder.reset(nw);
 
-            std::atomic<int> MST_weight;
+            // Dense ids of the components left by each iteration
+            Relabeling relabeling;
 
             long total_time = 0;        
 
             int iter = 0;
 
-            while (graph.getNumNodes() != 1) {
+            if (filter_kruskal) {
+
+                Utimer timer("Filter-Kruskal time", &total_time);
+
+                FilterKruskal engine (view.originalNodes, nw);
+
+                engine.run(view.ownEdges());
+
+                for (uint id : engine.forestEdges())
+                    recorder.record(0, id);
+
+                // Each sorted partition counts as an iteration
+                iter = engine.sortedPartitions();
+
+            }
+
+            // Number of surviving edges of each chunk, the survivors are then written into the buffer of the view the round is not reading
+            std::vector<size_t> survivors (nw + 1, 0);
+
+            // Minimum edges of each worker and of each node, sized by the first round and only reset by the next ones
+            std::vector<std::vector<IdEdge>> local_edges (atomic_min ? 0 : nw);
+
+            std::vector<IdEdge> global_edges;
+
+            while (!filter_kruskal && view.getNumNodes() != 1 && view.getNumEdges() != 0) {
 
-                uint num_edge = graph.getNumEdges();
+                uint num_edge = view.getNumEdges();
 
-                std::vector<std::vector<MyEdge>> local_edges (nw);
+                ArrayRef<MyEdge> edges = view.edges();
+
+                EdgeIds ids = view.ids();
 
                 for (auto &local_edge : local_edges) {
-                    local_edge.assign(graph.originalNodes, {0,0,10});
+                    local_edge.assign(view.originalNodes, {0, 0, MAX_WEIGHT});
                 }
 
                 long map_time;
@@ -85,42 +145,54 @@ int main(int argc, char *argv[]) {
                 {
 
                     Utimer timer("Map parallel time", &map_time);
+
+                    if (atomic_min) {
+
+                        pf.parallel_for_idx(0, view.originalNodes, 1, 0, [&](const long start, const long stop, const int thid) {
+                            packed_minima.reset(start, stop);
+                        });
+
+                        pf.parallel_for_idx(0, num_edge, 1, 0, [&](const long start, const long stop, const int thid) {
+
+                            for (uint i = start; i < stop; i++) {
+                                // Every worker writes straight into the shared slots of the endpoints
+                                packed_minima.offerEdge(edges[i], i);
+                            }
+                        });
+
+                    }
+                    else {
                 
-                    pf.parallel_for_idx(0, num_edge, 1, 0, [&](const long start, const long stop, const int thid) {
+                        pf.parallel_for_idx(0, num_edge, 1, 0, [&](const long start, const long stop, const int thid) {
 
-                        for (uint i = start; i < stop; i++) {
-                            // Retrieve edge from graph
-                            MyEdge edge = graph.edges[i];
-
-                            if (local_edges[thid][edge.from].weight > edge.weight) {
-                                // Found edge with same starting node and minimum weight, update local_edge
-                                local_edges[thid][edge.from].weight = edge.weight;
-                                local_edges[thid][edge.from].from = edge.from;
-                                local_edges[thid][edge.from].to = edge.to;
+                            for (uint i = start; i < stop; i++) {
+                                // Retrieve edge from graph
+                                // The edge is stored once, it is a candidate for both its endpoints
+                                offer_edge(local_edges[thid], edges[i], ids, i);
                             }
-                        }
-                    });
+                        });
+
+                    }
 
                 }
 
-                std::vector<MyEdge> global_edges (graph.originalNodes, {0, 0, 10});
+                long merge_time = 0;
 
-                long merge_time;
+                if (!atomic_min) {
 
-                {
                     Utimer timer("Merge edges", &merge_time);
 
+                    global_edges.assign(view.originalNodes, {0, 0, MAX_WEIGHT});
+
                     pf.parallel_for_idx(0, local_edges[0].size(), 1, 0, [&](const long start, const long stop, const int thid) {
 
                         // For each local_edge of each thread
                         for (auto &local_edge : local_edges) {
                             // Iterate through the indexes interval received
                             for (uint i = start; i < stop; i++) {
-                                if (local_edge[i].weight < global_edges[i].weight) {
+                                if (lighter(local_edge[i], global_edges[i])) {
                                     // Update global_edges if the local_edges found by the thread i has a better weight
-                                    global_edges[i].weight = local_edge[i].weight;
-                                    global_edges[i].from = local_edge[i].from;
-                                    global_edges[i].to = local_edge[i].to;
+                                    global_edges[i] = local_edge[i];
                                 }
                             }
                         }
@@ -131,30 +203,31 @@ int main(int argc, char *argv[]) {
                 
                 long contraction_time;
 
+                // Edges added to the spanning forest by the contraction
+                size_t merged;
+
                 {
 
                     Utimer timer("Contraction nodes", &contraction_time);
 
-                    pf.parallel_for_idx(0, global_edges.size(), 1, 0, [&](const long start, const long stop, const int thid) {
+                    pf.parallel_for_idx(0, atomic_min ? view.originalNodes : global_edges.size(), 1, 0, [&](const long start, const long stop, const int thid) {
 
                         // Iterate through global_edges in the specific indexes
                         for (uint i = start; i < stop; i++) {
                             // Retrieve the edge found
-                            MyEdge edge = global_edges[i];
+                            IdEdge edge = atomic_min ? packed_minima.edgeOf(i, edges, ids) : global_edges[i];
                             
                             if (edge == NULL_CONN) {
                                 // If edge has default value, we do nothing
                             }
                             else {
-                                if (!initialComponents.same(edge.from, edge.to)) {
+                                if (initialComponents.merge(edge.from, edge.to)) {
                                     /**
                                      * Access the UNION-FIND data structure and check if the starting node and ending node 
                                      * have the same parent.
-                                     * If not, this means that we can unify the two trees 
+                                     * If not, the two trees have been unified: only one of the workers unifying them gets here
                                      */
-                                    initialComponents.unite(edge.from, edge.to);
-                                    // MST_weight.fetch_add(edge.weight);
-                                    // MST_weight += edge.weight;
+                                    recorder.record(thid, edge.id);
                                 }
                                 else {
                                     /**
@@ -165,87 +238,140 @@ int main(int argc, char *argv[]) {
                             }
                         }
                     });
+
+                    merged = recorder.endRound();
                 }
 
-                std::vector<std::vector<MyEdge>> selected_edges (nw);
-                std::vector<std::vector<uint>> selected_nodes (nw);
+                // Nothing to contract although edges are left (e.g. NaN weights, never picked): the next rounds would be the same
+                if (merged == 0) {
+                    total_time += map_time + merge_time + contraction_time;
+                    break;
+                }
 
-                long filtering_edge_time;
+                long filtering_node_time;
 
                 {
 
-                    Utimer timer("Filter edges", &filtering_edge_time);
+                    Utimer timer("Filter nodes", &filtering_node_time);
 
-                    pf.parallel_for_idx(0, num_edge, 1, 0, [&](const long start, const long stop, const int thid) {
+                    uint num_node = view.getNumNodes();
 
-                        // Iterate through the received indexes 
-                        for (uint i = start; i < stop; i++) {
-                            
-                            MyEdge edge = graph.edges[i];
+                    relabeling.reset(view.originalNodes, nw);
 
-                            if ( !initialComponents.same(edge.from, edge.to) )
-                                /**
-                                 * If the starting and the ending node of each graph's edge are not in the same component, 
-                                 * then we need to keep it for the next iteration.
-                                 * Otherwise we discard it.
-                                 */
-                                selected_edges[thid].push_back(edge);
-                        }
+                    /**
+                     * The parent nodes are the components left for the next iteration, they are numbered densely:
+                     * each chunk counts its parent nodes, then numbers them starting from the prefix sum of the counts
+                     * of the previous chunks. Chunk r is made of the nodes [r * num_node / nw, (r + 1) * num_node / nw).
+                     */
+                    pf.parallel_for(0, nw, 1, 1, [&](const long r) {
+                        relabeling.countRoots(initialComponents, view.nodes(), r * num_node / nw, (r + 1) * num_node / nw, r);
+                    });
+
+                    relabeling.prefixSum();
+
+                    pf.parallel_for(0, nw, 1, 1, [&](const long r) {
+                        relabeling.assignLabels(initialComponents, view.nodes(), r * num_node / nw, (r + 1) * num_node / nw, r);
+                    });
+
+                    // Once all the parent nodes are numbered, the new id of the component of every node goes into a plain array
+                    pf.parallel_for_idx(0, view.originalNodes, 1, 0, [&](const long start, const long stop, const int thid) {
+                        relabeling.flatten(initialComponents, start, stop);
                     });
 
                 }
 
-                long filtering_node_time;
+                long filtering_edge_time;
 
                 {
 
-                    Utimer timer("Filter nodes", &filtering_node_time);
+                    Utimer timer("Filter edges", &filtering_edge_time);
 
-                    pf.parallel_for_idx(0, graph.originalNodes, 1, 0, [&](const long start, const long stop, const int thid) {
-                        // Iterate through the received indexes 
-                        for (uint i = start; i < stop; i++) {
-                            if ( initialComponents.parent(graph.nodes[i]) == graph.nodes[i] ) 
+                    /**
+                     * Two passes over the same chunks: each chunk counts its surviving edges, then writes them into next_edges
+                     * starting from the prefix sum of the counts of the previous chunks, so the edges keep their order.
+                     * Chunk r is made of the edges [r * num_edge / nw, (r + 1) * num_edge / nw).
+                     */
+                    pf.parallel_for(0, nw, 1, 1, [&](const long r) {
+                        size_t count = 0;
+                        for (uint i = r * num_edge / nw; i < (r + 1) * num_edge / nw; i++) {
+                            MyEdge edge = edges[i];
+                            count += relabeling.relabel(edge);
+                        }
+                        survivors[r + 1] = count;
+                    });
+
+                    for (int r = 0; r < nw; r++)
+                        survivors[r + 1] += survivors[r];
+
+                    EdgeBuffer &next_edges = view.survivors(survivors[nw]);
+
+                    IdBuffer &next_ids = view.survivorIds();
+
+                    pf.parallel_for(0, nw, 1, 1, [&](const long r) {
+
+                        size_t position = survivors[r];
+
+                        // Iterate through the edges of the chunk
+                        for (uint i = r * num_edge / nw; i < (r + 1) * num_edge / nw; i++) {
+                            
+                            MyEdge edge = edges[i];
+
+                            if ( relabeling.relabel(edge) ) {
                                 /**
-                                 * If the parent node is the same as the node itself, then we need to keep it also 
-                                 * for next iteration.
-                                 * Otherwise it is a child of another node and we can discard it.
+                                 * If the starting and the ending node of each graph's edge are not in the same component, 
+                                 * then we need to keep it for the next iteration, between the new ids of the two components,
+                                 * along with its id. Otherwise we discard it.
                                  */
-                                selected_nodes[thid].push_back(i);
-                        }  
+                                next_ids[position] = ids[i];
+                                next_edges[position++] = edge;
+                            }
+                        }
                     });
 
                 }
 
-                std::vector<MyEdge> remaining_edges;
-                std::vector<uint> remaining_nodes;
-
                 long filtering_time;
 
                 {
                     Utimer timer("Final filtering", &filtering_time);
 
-                    for (auto &vect : selected_edges) {
-                        remaining_edges.insert(remaining_edges.end(), vect.begin(), vect.end());
-                    }
-
-                    for (auto &vect : selected_nodes) {
-                        remaining_nodes.insert(remaining_nodes.end(), vect.begin(), vect.end());
-                    }
+                    view.useSurvivors();
 
                 }
 
                 total_time += map_time + merge_time + contraction_time + filtering_edge_time + filtering_node_time + filtering_time; 
 
-                graph.updateNodes(std::ref(remaining_nodes));
-                graph.updateEdges(std::ref(remaining_edges));
+                // The next iteration works on the new ids of the components
+                view.renumberNodes(relabeling.numLabels());
+
+                initialComponents = DisjointSets(view.originalNodes);
 
                 iter++;
 
             }
             
-            std::cout << "workers: " << nw << "; iters: " << iter << "; time " << total_time << " usec" << std::endl;
+            MST mst;
+
+            long mst_time;
+
+            {
+                Utimer timer("MST time", &mst_time);
+
+                mst = recorder.resolve(graph.getEdges());
+
+                mst.findTrees(graph.getNodes(), graph.originalNodes);
+            }
+
+            print_mst(mst);
+
+            if (options.has("mst"))
+                write_mst(options.get("mst"), mst);
+
+            if (options.has("forest"))
+                write_forest(options.get("forest"), mst);
 
-            graph = copy_graph;
+            // The tree is resolved once the rounds are over, its time is not part of the time of the algorithm
+            std::cout << "workers: " << nw << "; iters: " << iter << "; time " << total_time << " usec; mst time " << mst_time << " usec" << std::endl;
 
             iters--;
 
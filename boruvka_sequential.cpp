@@ -1,15 +1,21 @@
 #include <iostream>
 #include <thread>
-#include "lib/components.hpp"
 #include "lib/dset.hpp"
+#include "lib/graph.hpp"
+#include "lib/utils.hpp"
+#include "lib/utimer.hpp"
+#include "lib/options.hpp"
+#include "lib/relabel.hpp"
+#include "lib/filter_kruskal.hpp"
+#include "lib/mst.hpp"
 #include <algorithm>
 #include <atomic>
 
 
 int main(int argc, char *argv[]) {
 
-    if (argc != 5) {
-        std::cout << "Usage ./[executable] number_nodes number_edges filename iters" << std::endl;
+    if (argc < 5) {
+        std::cout << "Usage ./[executable] number_nodes number_edges filename iters [key=value ...]" << std::endl;
         return (0);
     }
 
@@ -21,6 +27,8 @@ int main(int argc, char *argv[]) {
 
     int iters = std::atoi(argv[4]);
 
+    Options options(argc, argv, 5);
+
     Graph graph; // = Graph();
     
     long loading_time = 0;
@@ -29,58 +37,100 @@ int main(int argc, char *argv[]) {
 
         Utimer read_time("loading graph",&loading_time);
 
-        // UNCOMMENT FOR V_E and sc-rel9
         if (filename.empty()) {
-            graph.generateGraph(num_nodes, num_edges);
+            graph.generateGraph(num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_generator(filename)) {
+            graph.generateGraph(filename, num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_snapshot(filename)) {
+            graph.loadSnapshot(filename);
         }
         else {
-            graph.loadGraph(filename);
+            graph.loadGraph(filename, options.get("format", ""), options.getLong("seed", 1), options.get("jitter", "0") != "0");
         }
-        // UNCOMMENT FOR soc-youtube
-        // graph.loadGraphUnweighted(filename);
 
     }
 
     std::cout << "sequential; read time: " << loading_time << " usec" << std::endl;
 
-    Graph copy_graph = graph;
+    if (options.has("save")) {
+        graph.saveSnapshot(options.get("save"));
+        std::cout << "snapshot saved to " << options.get("save") << std::endl;
+    }
+
+    // The loaded graph is never modified: every run works on a view of it, whose buffers are reused by the next runs
+    GraphView view (graph);
+
+    // MST engine: the Boruvka rounds or Filter-Kruskal
+    bool filter_kruskal = options.get("engine", "boruvka") == "filterkruskal";
 
     while (iters > 0) {
+
+        view.reset();
     
         // Disjoint Union Find structure
-        DisjointSets initialComponents = { static_cast<uint32_t>(graph.getNumNodes()) };
+        DisjointSets initialComponents = { static_cast<uint32_t>(view.originalNodes) };
+
+        // Edges added to the spanning tree
+        MSTRecorder recorder;
 
-        std::atomic<int> MST_weight;
+        recorder.reset(1);
+
+        // Dense ids of the components left by each iteration
+        Relabeling relabeling;
 
         int iter = 0;
 
         long total_time = 0;
+
+        if (filter_kruskal) {
+
+            Utimer timer("Filter-Kruskal time", &total_time);
+
+            FilterKruskal engine (view.originalNodes, 1);
+
+            engine.run(view.ownEdges());
+
+            for (uint id : engine.forestEdges())
+                recorder.record(0, id);
+
+            // Each sorted partition counts as an iteration
+            iter = engine.sortedPartitions();
+
+        }
+
+        // Minimum edge of each node, sized by the first round and only reset by the next ones
+        std::vector<IdEdge> global_edges;
         
-        while (graph.getNumNodes() != 1) {
+        while (!filter_kruskal && view.getNumNodes() != 1 && view.getNumEdges() != 0) {
 
-            std::vector<MyEdge> global_edges (graph.originalNodes, {0, 0, 10});
+            global_edges.assign(view.originalNodes, {0, 0, MAX_WEIGHT});
 
             long map_time;
 
             {
                 Utimer timer("Minimum searching", &map_time);
 
-                for (auto &edge : graph.edges) {
-                    if (global_edges[edge.from].weight > edge.weight) {
-                        // Update global_edges if the local_edges found by the thread i has a better weight
-                        global_edges[edge.from].weight = edge.weight;
-                        global_edges[edge.from].from = edge.from;
-                        global_edges[edge.from].to = edge.to;
-                    }
+                ArrayRef<MyEdge> edges = view.edges();
+
+                EdgeIds ids = view.ids();
+
+                for (size_t i = 0; i < edges.size(); i++) {
+                    // The edge is stored once, it is a candidate for both its endpoints
+                    offer_edge(global_edges, edges[i], ids, i);
                 }
 
             }
             
 
-            MyEdge NULL_CONN = {0, 0, 10};
+            MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
 
             long contraction_time;
 
+            // Edges added to the spanning forest by the contraction
+            size_t merged;
+
             {
                 Utimer timer("Contraction time", &contraction_time);
 
@@ -89,13 +139,13 @@ int main(int argc, char *argv[]) {
                         // If edge has default value, we do nothing
                     }
                     else {
-                        if (!initialComponents.same(edge.from, edge.to)) {
+                        if (initialComponents.merge(edge.from, edge.to)) {
                             /**
                              * Access the UNION-FIND data structure and check if the starting node and ending node 
                              * have the same parent.
-                             * If not, this means that we can unify the two trees 
+                             * If not, the two trees have been unified and the edge is part of the spanning tree
                              */
-                            initialComponents.unite(edge.from, edge.to);
+                            recorder.record(0, edge.id);
                         }
                         else {
                             /**
@@ -106,60 +156,140 @@ int main(int argc, char *argv[]) {
                     }
                 }
 
+                merged = recorder.endRound();
+
+            }
+
+            // Nothing to contract although edges are left (e.g. NaN weights, never picked): the next rounds would be the same
+            if (merged == 0) {
+                total_time += map_time + contraction_time;
+                break;
             }
 
-            std::vector<MyEdge> remaining_edges;
-            std::vector<uint> remaining_nodes;
+            long filtering_node_time;
+
+            {
+                Utimer timer("Filtering nodes", &filtering_node_time);
+
+                /**
+                 * The nodes that are still their own parent are the components left for the next iteration.
+                 * They are numbered densely in node order, so that the next iteration only deals with them.
+                 */
+                relabeling.reset(view.originalNodes, 1);
+                relabeling.countRoots(initialComponents, view.nodes(), 0, view.getNumNodes(), 0);
+                relabeling.prefixSum();
+                relabeling.assignLabels(initialComponents, view.nodes(), 0, view.getNumNodes(), 0);
+                relabeling.flatten(initialComponents, 0, view.originalNodes);
+
+            }
 
             long filtering_edge_time;
 
             {
                 Utimer timer("Filtering edge", &filtering_edge_time);
 
-                for (auto &edge : graph.edges) {
-                    if ( !initialComponents.same(edge.from, edge.to) )
-                    /**
-                     * If the starting and the ending node of each graph's edge are not in the same component, 
-                     * then we need to keep it for the next iteration.
-                     * Otherwise we discard it.
-                     */
-                        remaining_edges.push_back(edge);
+                ArrayRef<MyEdge> edges = view.edges();
+
+                EdgeIds ids = view.ids();
+
+                /**
+                 * If the starting and the ending node of each graph's edge are not in the same component, 
+                 * then we need to keep it for the next iteration, between the new ids of the two components.
+                 * Otherwise we discard it.
+                 * The first round appends the survivors and their ids to the buffers of the view, reserved for all the loaded edges so
+                 * that they are never reallocated and only the pages of the survivors are written. The next rounds compact those buffers
+                 * in place: the survivors never get ahead of the edge being read.
+                 */
+                EdgeBuffer &next_edges = view.survivors(0, true);
+
+                IdBuffer &next_ids = view.survivorIds();
+
+                if (next_edges.data() == edges.data()) {
+
+                    size_t kept = 0;
+
+                    for (size_t i = 0; i < next_edges.size(); i++) {
+                        MyEdge edge = next_edges[i];
+                        if ( relabeling.relabel(edge) ) {
+                            next_ids[kept] = next_ids[i];
+                            next_edges[kept++] = edge;
+                        }
+                    }
+
+                    next_edges.resize(kept);
+                    next_ids.resize(kept);
+
                 }
+                else {
 
-            }
+                    next_edges.reserve(edges.size());
+                    next_ids.reserve(edges.size());
 
-            long filtering_node_time;
+                    // Appended a block at a time, the survivors are gathered in a small array in between
+                    MyEdge block[256];
 
-            {
-                Utimer timer("Filtering nodes", &filtering_node_time);
+                    uint block_ids[256];
+
+                    size_t count = 0;
+
+                    for (size_t i = 0; i < edges.size(); i++) {
+                        MyEdge edge = edges[i];
+                        if ( relabeling.relabel(edge) ) {
+                            block_ids[count] = ids[i];
+                            block[count++] = edge;
+                            if (count == 256) {
+                                next_edges.insert(next_edges.end(), block, block + count);
+                                next_ids.insert(next_ids.end(), block_ids, block_ids + count);
+                                count = 0;
+                            }
+                        }
+                    }
+
+                    next_edges.insert(next_edges.end(), block, block + count);
+                    next_ids.insert(next_ids.end(), block_ids, block_ids + count);
 
-                for (uint i = 0; i < graph.nodes.size(); i++) {
-                    if ( initialComponents.parent(i) == i ) 
-                        /**
-                         * If the parent node is the same as the node itself, then we need to keep it also 
-                         * for next iteration.
-                         * Otherwise it is a child of another node and we can discard it.
-                         */
-                        remaining_nodes.push_back(i);
                 }
 
+                view.useSurvivors();
+
             }
 
 
             total_time += map_time + contraction_time + filtering_edge_time + filtering_node_time; 
 
-            graph.updateNodes(std::ref(remaining_nodes));
-            graph.updateEdges(std::ref(remaining_edges));
+            view.renumberNodes(relabeling.numLabels());
+
+            // The next iteration works on the new ids
+            initialComponents = DisjointSets(view.originalNodes);
 
             iter++;
 
         }   
 
-        std::cout << "sequential; iters: " << iter << "; time: " << total_time << " usec" << std::endl;
+        MST mst;
 
-        iters--;
+        long mst_time;
+
+        {
+            Utimer timer("MST time", &mst_time);
+
+            mst = recorder.resolve(graph.getEdges());
 
-        graph = copy_graph;
+            mst.findTrees(graph.getNodes(), graph.originalNodes);
+        }
+
+        print_mst(mst);
+
+        if (options.has("mst"))
+            write_mst(options.get("mst"), mst);
+
+        if (options.has("forest"))
+            write_forest(options.get("forest"), mst);
+
+        // The tree is resolved once the rounds are over, its time is not part of the time of the algorithm
+        std::cout << "sequential; iters: " << iter << "; time: " << total_time << " usec; mst time: " << mst_time << " usec" << std::endl;
+
+        iters--;
 
     }
 
@@ -4,11 +4,27 @@
 #include <algorithm>
 #include <atomic>
 #include <future>
+#include <memory>
+#include <numeric>
 #include "lib/queue.hpp"
 #include "lib/graph.hpp"
 #include "lib/utils.hpp"
 #include "lib/utimer.hpp"
+#include "lib/options.hpp"
 #include "lib/threadpool.hpp"
+#include "lib/external.hpp"
+#include "lib/compressed.hpp"
+#include "lib/csr.hpp"
+#include "lib/relabel.hpp"
+#include "lib/minima.hpp"
+#include "lib/soa.hpp"
+#include "lib/simd.hpp"
+#include "lib/stars.hpp"
+#include "lib/finish.hpp"
+#include "lib/filter_kruskal.hpp"
+#include "lib/mst.hpp"
+#include "lib/incremental.hpp"
+#include "lib/stream.hpp"
 
 #define MY_EOS std::pair<uint,uint> (0,0)
 
@@ -24,10 +40,10 @@
  * 
  * Loop through the assigned indexes chunk_indexes and modify the local_edges at the given index thread with the minimum edges found
  */
-int mapwork(std::vector<std::vector<MyEdge>> &local_edges, Graph &graph, std::pair<uint, uint> chunk_indexes, uint index) {
+int mapwork(std::vector<std::vector<IdEdge>> &local_edges, const GraphView &graph, std::pair<uint, uint> chunk_indexes, uint index) {
 
     // local_edges.resize(graph.originalNodes);
-    local_edges[index].assign(graph.originalNodes, {0,0,10});
+    local_edges[index].assign(graph.originalNodes, {0, 0, MAX_WEIGHT});
     // std::cout << local_edges[index].size() << std::endl;
 
     // Get the indexes of the edges array
@@ -37,16 +53,16 @@ int mapwork(std::vector<std::vector<MyEdge>> &local_edges, Graph &graph, std::pa
 
     // std::cout << starting_index << "," << ending_index << std::endl;
 
+    ArrayRef<MyEdge> edges = graph.edges();
+
+    EdgeIds ids = graph.ids();
+
     for (uint i = starting_index; i < ending_index; i++) {
         // Retrieve edge from graph
-        MyEdge &edge = graph.edges[i];
+        const MyEdge &edge = edges[i];
 
-        if (local_edges[index][edge.from].weight > edge.weight) {
-            // Found edge with same starting node and minimum weight, update local_edge
-            local_edges[index][edge.from].weight = edge.weight;
-            local_edges[index][edge.from].from = edge.from;
-            local_edges[index][edge.from].to = edge.to;
-        }
+        // The edge is stored once, it is a candidate for both its endpoints
+        offer_edge(local_edges[index], edge, ids, i);
     }
 
     return 1;
@@ -64,7 +80,7 @@ int mapwork(std::vector<std::vector<MyEdge>> &local_edges, Graph &graph, std::pa
  * 
  * Each thread inspect the local_edges and update the global_edges vector with the minimum edge found previously 
  */
-int mergework(std::vector<std::vector<MyEdge>> &local_edges, std::vector<MyEdge> &global_edges, std::pair<uint, uint> chunk_indexes) {
+int mergework(std::vector<std::vector<IdEdge>> &local_edges, std::vector<IdEdge> &global_edges, std::pair<uint, uint> chunk_indexes) {
 
     // Get the indexes of the local_edges array
     uint starting_index = chunk_indexes.first;
@@ -74,16 +90,14 @@ int mergework(std::vector<std::vector<MyEdge>> &local_edges, std::vector<MyEdge>
     // std::cout << starting_index << "," << ending_index << std::endl;
 
     // For each local_edge of each thread
-    for (auto local_edge : local_edges) {
+    for (auto &local_edge : local_edges) {
         
         // Iterate through the indexes interval received
         for (uint i = starting_index; i < ending_index; i++) {
             
-            if (local_edge[i].weight < global_edges[i].weight) {
+            if (lighter(local_edge[i], global_edges[i])) {
                 // Update global_edges if the local_edges found by the thread i has a better weight
-                global_edges[i].weight = local_edge[i].weight;
-                global_edges[i].from = local_edge[i].from;
-                global_edges[i].to = local_edge[i].to;
+                global_edges[i] = local_edge[i];
             }
 
         }
@@ -101,16 +115,18 @@ int mergework(std::vector<std::vector<MyEdge>> &local_edges, std::vector<MyEdge>
  * @param global_edges The minimum vector of edges found in this iteration
  * @param initialComponents The disjoint sets data structure
  * @param graph The graph data structure
+ * @param mst The edges of the spanning tree, receiving the ones added by the thread
  * @param chunk_indexes The <starting, ending> integer pair to inspect in the global_edges vector
+ * @param index The index of the corresponding thread
  * @return int 
  * 
- * Contract the union find data structure by calling the method same and unite. If the minimum edge found among node x and y have already the same 
+ * Contract the union find data structure by calling the method merge. If the minimum edge found among node x and y have already the same 
  * parent, then we don't do nothing. 
- * Otherwise, we call unite to fuse together the two subtrees
+ * Otherwise, merge fuses together the two subtrees and the edge is added to the spanning tree
  */
-int contractionwork(std::vector<MyEdge> &global_edges, DisjointSets &initialComponents, Graph &graph, std::pair<uint, uint> chunk_indexes) {
+int contractionwork(std::vector<IdEdge> &global_edges, DisjointSets &initialComponents, const GraphView &graph, MSTRecorder &mst, std::pair<uint, uint> chunk_indexes, int index) {
 
-    MyEdge NULL_CONN = {0,0,10};
+    MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
 
     // Get the indexes of the global_edges array
     uint starting_index = chunk_indexes.first;
@@ -121,21 +137,19 @@ int contractionwork(std::vector<MyEdge> &global_edges, DisjointSets &initialComp
     for (uint i = starting_index; i < ending_index; i++) {
 
         // Retrieve the edge found
-        MyEdge edge = global_edges[i];
+        IdEdge edge = global_edges[i];
         
         if (edge == NULL_CONN) {
             // If edge has default value, we do nothing
         }
         else {
-            if (!initialComponents.same(edge.from, edge.to)) {
+            if (initialComponents.merge(edge.from, edge.to)) {
                 /**
                  * Access the UNION-FIND data structure and check if the starting node and ending node 
                  * have the same parent.
-                 * If not, this means that we can unify the two trees 
+                 * If not, the two trees have been unified: only one of the threads unifying them gets here
                  */
-                initialComponents.unite(edge.from, edge.to);
-                // MST_weight.fetch_add(edge.weight);
-                // MST_weight += edge.weight;
+                mst.record(index, edge.id);
             }
             else {
                 /**
@@ -152,75 +166,190 @@ int contractionwork(std::vector<MyEdge> &global_edges, DisjointSets &initialComp
 
 
 /**
- * @brief Filter the edges found previously
+ * @brief Compute minimum edges of the graph into the shared packed slots
  * 
- * @param remaining_edges Vector of vector of edges to modify 
- * @param initialComponents The disjoint set data structure
- * @param graph The graph data structure
- * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph edges
+ * @param minima The packed minimum edge of each node, shared by all the threads
+ * @param edges The edges accessed concurrently, either the edges of the graph or EdgeArrays
+ * @param chunk_indexes The <starting,ending> integer pair of edges to inspect
+ * @return int 
+ * 
+ * Same as mapwork, but every edge is offered with a lock-free write-min straight into the shared slots of its endpoints, 
+ * so there is no local copy to merge afterwards
+ */
+template <typename EdgesT>
+int atomicmapwork(PackedMinima &minima, const EdgesT &edges, std::pair<uint, uint> chunk_indexes) {
+
+    for (uint i = chunk_indexes.first; i < chunk_indexes.second; i++) {
+        minima.offerEdge(edges[i], i);
+    }
+
+    return 1;
+
+}
+
+
+/**
+ * @brief Contract the union find data structure along the packed minimum edges
+ * 
+ * @param minima The packed minimum edge of each node found in this iteration
+ * @param initialComponents The disjoint sets data structure
+ * @param edges The edges referenced by the packed slots
+ * @param ids The ids of the edges
+ * @param mst The edges of the spanning tree, receiving the ones added by the thread
+ * @param chunk_indexes The <starting, ending> integer pair of nodes to inspect
  * @param index The index of the corresponding thread
  * @return int 
  * 
- * Loop through the edges of the graph and append the edge into the corresponding remaining_edges index if the node x and y linking the current edge does 
- * not belong to the same component
+ * Same as contractionwork, unpacking the minimum edge of each node
  */
-int filteringedgework(std::vector<std::vector<MyEdge>>& remaining_edges, DisjointSets &initialComponents, Graph &graph, std::pair<uint, uint> chunk_indexes, int index) {
+template <typename EdgesT>
+int atomiccontractionwork(PackedMinima &minima, DisjointSets &initialComponents, const EdgesT &edges, EdgeIds ids, MSTRecorder &mst, std::pair<uint, uint> chunk_indexes, int index) {
 
-    // Get the indexes 
-    uint starting_index = chunk_indexes.first;
+    MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
 
-    uint ending_index = chunk_indexes.second;
+    for (uint i = chunk_indexes.first; i < chunk_indexes.second; i++) {
 
-    // Iterate through the received indexes 
-    for (uint i = starting_index; i < ending_index; i++) {
-        
-        MyEdge edge = graph.edges[i];
+        IdEdge edge = minima.edgeOf(i, edges, ids);
 
-        if ( !initialComponents.same(edge.from, edge.to) )
-            /**
-             * If the starting and the ending node of each graph's edge are not in the same component, 
-             * then we need to keep it for the next iteration.
-             * Otherwise we discard it.
-             */
-            remaining_edges[index].push_back(edge);
+        if (!(edge == NULL_CONN) && initialComponents.merge(edge.from, edge.to))
+            mst.record(index, edge.id);
+
+    }
+
+    return 1;
+
+}
+
+
+/**
+ * @brief Hook the nodes to the other endpoint of their minimum edge
+ * 
+ * @param stars The star contraction of this iteration
+ * @param minEdge Function giving the minimum edge of a node, from global_edges or from the packed slots
+ * @param chunk_indexes The <starting, ending> integer pair of nodes to hook
+ * @return int 
+ * 
+ * First step of the contraction by pointer jumping, the alternative to contractionwork
+ */
+template <typename MinEdgeF>
+int hookingwork(StarContraction &stars, MinEdgeF minEdge, std::pair<uint, uint> chunk_indexes) {
+
+    stars.hook(chunk_indexes.first, chunk_indexes.second, minEdge);
+
+    return 1;
+
+}
+
+
+/**
+ * @brief Break the 2-cycles left by hookingwork
+ * 
+ * @param stars The star contraction of this iteration
+ * @param mst The edges of the spanning tree, receiving the hooks of the nodes that are not roots
+ * @param chunk_indexes The <starting, ending> integer pair of nodes to inspect
+ * @param index The index of the corresponding thread
+ * @return int 
+ */
+int cyclework(StarContraction &stars, MSTRecorder &mst, std::pair<uint, uint> chunk_indexes, int index) {
+
+    stars.breakCycles(chunk_indexes.first, chunk_indexes.second, [&mst, index](uint id) {
+        mst.record(index, id);
+    });
+
+    return 1;
+
+}
+
+
+/**
+ * @brief Move the nodes to the parent of their parent
+ * 
+ * @param stars The star contraction of this iteration
+ * @param moved Whether the nodes of each thread moved, the jumps go on until none does
+ * @param chunk_indexes The <starting, ending> integer pair of nodes to inspect
+ * @param index The index of the corresponding thread
+ * @return int 
+ */
+int jumpingwork(StarContraction &stars, std::vector<char> &moved, std::pair<uint, uint> chunk_indexes, int index) {
+
+    moved[index] = stars.jump(chunk_indexes.first, chunk_indexes.second);
+
+    return 1;
+
+}
+
+
+/**
+ * @brief Count the edges surviving the contraction, first pass of the edge filtering
+ * 
+ * @param survivors Number of surviving edges of each chunk, at index + 1
+ * @param relabeling The new ids of the components, flattened
+ * @param graph The graph data structure
+ * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph edges
+ * @param index The index of the corresponding thread
+ * @return int 
+ */
+int countingwork(std::vector<size_t> &survivors, const Relabeling &relabeling, const GraphView &graph, std::pair<uint, uint> chunk_indexes, int index) {
+
+    ArrayRef<MyEdge> edges = graph.edges();
+
+    size_t count = 0;
+
+    for (uint i = chunk_indexes.first; i < chunk_indexes.second; i++) {
+        MyEdge edge = edges[i];
+        count += relabeling.relabel(edge);
     }
 
+    survivors[index + 1] = count;
+
     return 1;
 
 }
 
 
 /**
- * @brief Filter the nodes found previously
+ * @brief Filter the edges found previously, second pass of the edge filtering
  * 
- * @param remaining_nodes Vector of vector of nodes to modify
- * @param initialComponents The disjoint set data structure
+ * @param next_edges Buffer receiving the surviving edges, of at least as many edges as they are
+ * @param next_ids Buffer receiving the ids of the surviving edges, at the same positions
+ * @param survivors Prefix sums of the counts of countingwork: the surviving edges of the chunk are written from survivors[index]
+ * @param relabeling The new ids of the components, flattened
  * @param graph The graph data structure
- * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph nodes
+ * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph edges, the same as in countingwork
  * @param index The index of the corresponding thread
  * @return int 
  * 
- * Inspect the given nodes indexes in the graph and check if the current node is itself a parent. 
- * If it is so, we save it into the remanining_nodes (only the parent node matters)
+ * Loop through the edges of the graph and write the edge into next_edges if the node x and y linking the current edge does 
+ * not belong to the same component, rewritten between the new ids of the two components. The chunks are written one after
+ * the other, in order, so the surviving edges keep their order
  */
-int filteringnodework(std::vector<std::vector<uint>>& remaining_nodes, DisjointSets &initialComponents, Graph &graph, std::pair<uint, uint> chunk_indexes, int index) {
+int filteringedgework(EdgeBuffer &next_edges, IdBuffer &next_ids, const std::vector<size_t> &survivors, const Relabeling &relabeling, const GraphView &graph, std::pair<uint, uint> chunk_indexes, int index) {
 
     // Get the indexes 
     uint starting_index = chunk_indexes.first;
 
     uint ending_index = chunk_indexes.second;
 
+    ArrayRef<MyEdge> edges = graph.edges();
+
+    EdgeIds ids = graph.ids();
+
+    size_t position = survivors[index];
+
     // Iterate through the received indexes 
     for (uint i = starting_index; i < ending_index; i++) {
+        
+        MyEdge edge = edges[i];
 
-        if ( initialComponents.parent(graph.nodes[i]) == graph.nodes[i] ) 
+        if ( relabeling.relabel(edge) ) {
             /**
-             * If the parent node is the same as the node itself, then we need to keep it also 
-             * for next iteration.
-             * Otherwise it is a child of another node and we can discard it.
+             * If the starting and the ending node of each graph's edge are not in the same component, 
+             * then we need to keep it for the next iteration, along with its id.
+             * Otherwise we discard it.
              */
-            remaining_nodes[index].push_back(i);
-        
+            next_ids[position] = ids[i];
+            next_edges[position++] = edge;
+        }
     }
 
     return 1;
@@ -228,389 +357,1273 @@ int filteringnodework(std::vector<std::vector<uint>>& remaining_nodes, DisjointS
 }
 
 
-int main(int argc, char *argv[]) {
+/**
+ * @brief Filter the edges of a segment and offer the survivors as minimum edges of the next iteration
+ *
+ * @param segments The <starting,ending> pair of the live edges of each thread in the edges of the graph
+ * @param relabeling The new ids of the components, flattened
+ * @param graph The graph data structure
+ * @param next_edges Buffer receiving the surviving edges at the same positions, the edges of the graph themselves after the first iteration
+ * @param next_ids Buffer receiving the ids of the surviving edges, at their positions in next_edges
+ * @param index The index of the corresponding thread
+ * @param offer Function called as offer(edge, position) on each surviving edge, relabeled, and its new position in next_edges
+ * @return int
+ *
+ * Fusion of filteringedgework with the mapwork of the next iteration: the surviving edges are moved to the front of the segment of
+ * the thread, which is never ahead of the edge being read, so once the first iteration has copied them out of the loaded graph they
+ * are compacted in place. The segments are not concatenated, each thread keeps working on its own segment in the next iterations
+ */
+template <typename OfferT>
+int fusedfilterwork(std::vector<std::pair<uint, uint>> &segments, const Relabeling &relabeling, const GraphView &graph, EdgeBuffer &next_edges, IdBuffer &next_ids,
+                    int index, OfferT offer) {
 
-    if (argc != 6) {
-        std::cout << "Usage ./[executable] nw number_nodes number_edges filename iters" << std::endl;
-        return (0);
-    }
+    ArrayRef<MyEdge> edges = graph.edges();
 
-    short num_w = std::stoi(argv[1]);
+    EdgeIds ids = graph.ids();
 
-    uint num_nodes = std::atoi(argv[2]);
+    uint kept = segments[index].first;
 
-    uint num_edges = std::atoi(argv[3]);
+    for (uint i = segments[index].first; i < segments[index].second; i++) {
 
-    std::string filename = std::string(argv[4]);
+        MyEdge edge = edges[i];
 
-    int iters = std::atoi(argv[5]);
+        if ( relabeling.relabel(edge) ) {
+            next_edges[kept] = edge;
+            next_ids[kept] = ids[i];
+            offer(edge, kept);
+            kept++;
+        }
 
-    long loading_time = 0;
+    }
 
-    Graph graph;// = Graph();
+    segments[index].second = kept;
 
-    {
+    return 1;
 
-        Utimer read_time("loading graph",&loading_time);
+}
 
-        // UNCOMMENT FOR V_E and sc-rel9
-        if (filename.empty()) {
-            graph.generateGraph(num_nodes, num_edges);
-        }
-        else {
-            graph.loadGraph(filename);
-        }
-        // UNCOMMENT FOR soc-youtube
-        // graph.loadGraphUnweighted(filename);
 
-    }
+/**
+ * @brief Count the nodes surviving the contraction
+ * 
+ * @param relabeling The new ids of the components, receiving the count of the thread
+ * @param initialComponents The disjoint set data structure, or the stars of StarContraction
+ * @param graph The graph data structure
+ * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph nodes
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * Inspect the given nodes indexes in the graph and count the ones that are themselves a parent (only the parent node matters)
+ */
+template <typename ComponentsT>
+int filteringnodework(Relabeling &relabeling, ComponentsT &initialComponents, const GraphView &graph, std::pair<uint, uint> chunk_indexes, int index) {
 
-    std::cout << "parallel thread; read time: " << loading_time << " usec" << std::endl;
+    relabeling.countRoots(initialComponents, graph.nodes(), chunk_indexes.first, chunk_indexes.second, index);
 
-    Graph copy_graph = graph;    
+    return 1;
 
-    for (int nw = 1; nw <= num_w; nw++) {
+}
 
-        // Instantiate the threadpool
-        ThreadPool pool{nw};
 
-        while (iters > 0) {
+/**
+ * @brief Give the new ids to the nodes surviving the contraction
+ * 
+ * @param relabeling The new ids of the components, after the prefix sum of the counts of filteringnodework
+ * @param initialComponents The disjoint set data structure, or the stars of StarContraction
+ * @param graph The graph data structure
+ * @param chunk_indexes The <starting,ending> integer pair to inspect in the graph nodes, the same as in filteringnodework
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * The parent nodes are numbered in node order starting from the number of parent nodes of the previous threads
+ */
+template <typename ComponentsT>
+int labelingwork(Relabeling &relabeling, ComponentsT &initialComponents, const GraphView &graph, std::pair<uint, uint> chunk_indexes, int index) {
 
-            // Disjoint Union Find structure
-            DisjointSets initialComponents = { static_cast<uint32_t>(graph.getNumNodes()) };
+    relabeling.assignLabels(initialComponents, graph.nodes(), chunk_indexes.first, chunk_indexes.second, index);
 
-            std::atomic<int> MST_weight;
+    return 1;
 
-            int iter = 0;
+}
 
-            long total_time = 0;
 
-            while (graph.getNumNodes() != 1) {
+/**
+ * @brief Flatten the union find data structure into the new ids of the components
+ * 
+ * @param relabeling The new ids of the components, after labelingwork
+ * @param initialComponents The disjoint set data structure, or the stars of StarContraction
+ * @param chunk_indexes The <starting,ending> integer pair of node ids to inspect
+ * @return int 
+ * 
+ * Write the new id of the component of each node into a plain array: the edges are then filtered with two loads per edge,
+ * without the find() walks on the shared parents
+ */
+template <typename ComponentsT>
+int flatteningwork(Relabeling &relabeling, ComponentsT &initialComponents, std::pair<uint, uint> chunk_indexes) {
 
-                // Vector of local MST
-                std::vector<std::vector<MyEdge>> local_edges (nw);
+    relabeling.flatten(initialComponents, chunk_indexes.first, chunk_indexes.second);
 
-                std::vector<MyEdge> global_edges;
-                global_edges.assign(graph.originalNodes, {0, 0, 10});
+    return 1;
 
-                std::vector<std::future<int>> mapfutures;
+}
 
-                long map_time;
 
-                {
+/**
+ * @brief Compute minimum edges of a compressed edge list
+ * 
+ * @param local_edges Vector of vector of edges to modify saving the minimum edges found
+ * @param edges The compressed edges accessed concurrently
+ * @param originalNodes The size of the node id range
+ * @param chunk_indexes The <starting,ending> integer pair of blocks to decode
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * Same as mapwork, decoding the assigned blocks one at a time
+ */
+int compressedmapwork(std::vector<std::vector<IdEdge>> &local_edges, const CompressedEdges &edges, uint originalNodes, std::pair<uint, uint> chunk_indexes, uint index) {
 
-                    Utimer timer("Map parallel time", &map_time);
+    local_edges[index].assign(originalNodes, {0, 0, MAX_WEIGHT});
 
-                    uint n = graph.getNumEdges();
+    std::vector<IdEdge> &local = local_edges[index];
 
-                    // Portion of edges for each worker
-                    size_t chunk_dim{ n / nw };
+    edges.decode(chunk_indexes.first, chunk_indexes.second, [&local](const MyEdge &edge, uint id, uint32_t) {
+        offer_edge(local, IdEdge{edge, id});
+    });
 
-                    // The starting index will be at zero
-                    size_t begin = 0;
+    return 1;
 
-                    // The ending one is n if the workers are enough, otherwise the chunk_dim computed before
-                    size_t end = nw != 1 ? std::min(chunk_dim, static_cast<size_t>(n)) : n;
+}
 
 
-                    if (nw == 1) {
-                        std::pair<uint, uint> chunk_indexes = {begin, end};
-                        auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                            return mapwork(std::ref(local_edges), std::ref(graph), std::move( chunk_indexes ), 0);
-                        }, 0);
+/**
+ * @brief Filter the edges of a compressed edge list
+ * 
+ * @param remaining_edges Vector of compressed lists receiving the surviving edges of each thread
+ * @param relabeling The new ids of the components, flattened
+ * @param edges The compressed edges accessed concurrently
+ * @param chunk_indexes The <starting,ending> integer pair of blocks to decode
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * Same as filteringedgework: the surviving edges are encoded again, over the new ids, as they are decoded
+ */
+int compressedfilterwork(std::vector<CompressedEdges> &remaining_edges, const Relabeling &relabeling, const CompressedEdges &edges, std::pair<uint, uint> chunk_indexes, int index) {
 
-                        mapfutures.push_back(std::move(f1));
-                    }
-                    else {
-                        for (int i = 0; i < nw; i++) {
-
-                            // Compute the indexes and enqueue the task into the thread pool
-                            std::pair<uint, uint> chunk_indexes = {begin, end};
-                            auto f1 = pool.enqueue([&, chunk_indexes, i]() -> int {
-                                return mapwork(std::ref(local_edges), std::ref(graph), std::move( chunk_indexes ), i);
-                            }, i);
-                            
-                            mapfutures.push_back(std::move(f1));
-
-                            if (i == nw-2) {
-                                // Last chunk
-                                begin = end;
-                                end = n;
-                            }
-                            else {
-                                begin = end;
-                                end = std::min(begin + chunk_dim, static_cast<size_t>(n));
-                            }
+    CompressedEdges &remaining = remaining_edges[index];
 
-                        }
-                    }
+    remaining = CompressedEdges();
+    remaining.inheritCoding(edges);
 
-                    // Wait for all the thread to finish
-                    for (auto &fut : mapfutures) {
-                        int val = fut.get();
-                    }
+    edges.decode(chunk_indexes.first, chunk_indexes.second, [&](MyEdge edge, uint id, uint32_t weight) {
+        if (relabeling.relabel(edge))
+            remaining.append(edge.from, edge.to, id, weight);
+    });
 
-                    
-                }
-    
-                long merge_time;
+    return 1;
 
-                std::vector<std::future<int>> mergefutures;
+}
 
-                {
 
-                    Utimer timer("Merge time", &merge_time);
+/**
+ * @brief Compute minimum edges of an edge list stored as a structure of arrays
+ * 
+ * @param local_edges Vector of vector of edges to modify saving the minimum edges found
+ * @param edges The edge arrays accessed concurrently
+ * @param originalNodes The size of the node id range
+ * @param chunk_indexes The <starting,ending> integer pair of edges to inspect
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * Same as mapwork
+ */
+int soamapwork(std::vector<std::vector<IdEdge>> &local_edges, const EdgeArrays &edges, uint originalNodes, std::pair<uint, uint> chunk_indexes, uint index) {
 
-                    uint n = local_edges[0].size();
+    local_edges[index].assign(originalNodes, {0, 0, MAX_WEIGHT});
 
-                    // Portion of edges for each worker
-                    size_t chunk_dim{ n / nw };
+    EdgeIds ids = edges.id.data();
 
-                    // The starting index will be at zero
-                    size_t begin = 0;
+    for (uint i = chunk_indexes.first; i < chunk_indexes.second; i++) {
+        offer_edge(local_edges[index], edges[i], ids, i);
+    }
 
-                    // The ending one is n if the workers are enough, otherwise the chunk_dim computed before
-                    size_t end = nw != 1 ? std::min(chunk_dim, static_cast<size_t>(n)) : n;
+    return 1;
 
-                    if (nw == 1) {
-                        std::pair<uint, uint> chunk_indexes = {begin, end};
-                        auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                            return mergework(std::ref(local_edges), std::ref(global_edges), std::move( chunk_indexes ));
-                        }, 0);
+}
 
-                        mergefutures.push_back(std::move(f1));
-                    }
-                    else {
-                        for (int i = 0; i < nw; i++) {
-                            
-                            std::pair<uint, uint> chunk_indexes = {begin, end};
-                            auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                                return mergework(std::ref(local_edges), std::ref(global_edges), std::move(chunk_indexes));
-                            }, std::move(i));
-
-                            mergefutures.push_back(std::move(f1));
-                            
-                            if (i == nw-2) {
-                                // Last chunk
-                                begin = end;
-                                end = n;
-                            }
-                            else {
-                                begin = end;
-                                end = std::min(begin + chunk_dim, static_cast<size_t>(n));
-                            }
 
-                        }
-                    }
+/**
+ * @brief Filter the edges of an edge list stored as a structure of arrays
+ * 
+ * @param remaining_edges Vector of edge arrays receiving the surviving edges of each thread
+ * @param edges The edge arrays accessed concurrently
+ * @param labels The new id of the component of each node
+ * @param simd The vector extension of the filtering kernel
+ * @param chunk_indexes The <starting,ending> integer pair of edges to inspect
+ * @param index The index of the corresponding thread
+ * @return int 
+ * 
+ * Same as filteringedgework: the components of the endpoints are gathered from labels, and the surviving edges are compress-stored 
+ * into the arrays of the thread, already relabeled
+ */
+int soafilterwork(std::vector<EdgeArrays> &remaining_edges, const EdgeArrays &edges, const std::vector<uint> &labels, SimdLevel simd, std::pair<uint, uint> chunk_indexes, int index) {
 
-                    for (auto &fut : mergefutures) {
-                        int val = fut.get();
-                    }
-    
-                }
+    EdgeArrays &remaining = remaining_edges[index];
 
-                long contraction_time;
+    uint first = chunk_indexes.first;
+    uint n = chunk_indexes.second - chunk_indexes.first;
 
-                std::vector<std::future<int>> contractionfutures;
+    remaining.resize(n);
 
-                {
+    size_t kept = filter_relabel(simd, edges.from.data() + first, edges.to.data() + first, edges.weight.data() + first, edges.id.data() + first, n, labels.data(),
+                                 remaining.from.data(), remaining.to.data(), remaining.weight.data(), remaining.id.data());
 
-                    Utimer timer("Contraction time", &contraction_time);
+    remaining.resize(kept);
 
-                    uint n = global_edges.size();
+    return 1;
 
-                    // Portion of edges for each worker
-                    size_t chunk_dim{ n / nw };
+}
 
-                    // The starting index will be at zero
-                    size_t begin = 0;
 
-                    // The ending one is n if the workers are enough, otherwise the chunk_dim computed before
-                    size_t end = nw != 1 ? std::min(chunk_dim, static_cast<size_t>(n)) : n;
+/**
+ * @brief Compute minimum edges of the rows of the adjacency
+ * 
+ * @param global_edges Global vector of minimum edges, written directly since each row belongs to a single thread
+ * @param csr The adjacency accessed concurrently
+ * @param chunk_indexes The <starting,ending> integer pair of rows to inspect
+ * @param simd The vector extension of the row scan
+ * @return int 
+ */
+int csrmapwork(std::vector<IdEdge> &global_edges, const CSRGraph &csr, std::pair<uint, uint> chunk_indexes, SimdLevel simd) {
 
-                    if (nw == 1) {
-                        std::pair<uint, uint> chunk_indexes = {begin, end};
-                        auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                            return contractionwork(std::ref(global_edges), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ));
-                        }, 0);
+    csr.rowMinima(chunk_indexes.first, chunk_indexes.second, global_edges, simd);
 
-                        contractionfutures.push_back(std::move(f1));
-                    }
-                    else {
-                        for (int i = 0; i < nw; i++) {
-                            
-                            std::pair<uint, uint> chunk_indexes = {begin, end};
-                            auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                                return contractionwork(std::ref(global_edges), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ));
-                            }, std::move(i));
-
-                            contractionfutures.push_back(std::move(f1));
-                            
-                            if (i == nw-2) {
-                                // Last chunk
-                                begin = end;
-                                end = n;
-                            }
-                            else {
-                                begin = end;
-                                end = std::min(begin + chunk_dim, static_cast<size_t>(n));
-                            }
+    return 1;
 
-                        }
-                    }
+}
 
-                    for (auto &fut : contractionfutures) {
-                        int val = fut.get();
-                    }
-    
-                }
 
-                long filtering_edge_time;
+/**
+ * @brief Split the given ranges among the workers of the pool and wait for them
+ * 
+ * @param pool The threadpool
+ * @param bounds The nw+1 bounds of the ranges, range i goes to thread i
+ * @param work Function called as work(chunk_indexes, index) by the thread index on its <starting,ending> pair
+ */
+template <typename WorkT>
+void dispatch_ranges(ThreadPool &pool, const std::vector<uint> &bounds, WorkT work) {
 
-                std::vector<std::future<int>> filtering_edgefutures;
+    std::vector<std::future<int>> futures;
 
-                std::vector<std::vector<MyEdge>> selected_edges (nw);
+    for (int i = 0; i + 1 < static_cast<int>(bounds.size()); i++) {
 
-                std::vector<std::vector<uint>> selected_nodes (nw);
+        // Enqueue the task into the thread pool
+        std::pair<uint, uint> chunk_indexes = {bounds[i], bounds[i+1]};
+        auto f1 = pool.enqueue([&work, chunk_indexes, i]() -> int {
+            return work(chunk_indexes, i);
+        }, i);
 
-                {
+        futures.push_back(std::move(f1));
 
-                    Utimer timer("Filtering edges time", &filtering_edge_time);
+    }
 
-                    uint n = graph.getNumEdges();
+    // Wait for all the thread to finish
+    for (auto &fut : futures) {
+        fut.get();
+    }
 
-                    // Portion of edges for each worker
-                    size_t chunk_dim{ n / nw };
+}
 
-                    // The starting index will be at zero
-                    size_t begin = 0;
 
-                    // The ending one is n if the workers are enough, otherwise the chunk_dim computed before
-                    size_t end = nw != 1 ? std::min(chunk_dim, static_cast<size_t>(n)) : n;
+/**
+ * @brief Split n items among the workers of the pool and wait for them
+ * 
+ * @param pool The threadpool
+ * @param nw Number of workers
+ * @param n Number of items
+ * @param work Function called as work(chunk_indexes, index) by the thread index on its <starting,ending> pair
+ * 
+ * Each worker gets n / nw items, the last one also gets the remainder
+ */
+template <typename WorkT>
+void dispatch(ThreadPool &pool, int nw, uint n, WorkT work) {
 
-                    if (nw == 1) {
-                        std::pair<uint, uint> chunk_indexes = {begin, end};
-                        auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                            return filteringedgework(std::ref(selected_edges), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ), 0);
-                        }, 0);
+    // Portion of items for each worker
+    uint chunk_dim{ n / nw };
 
-                        filtering_edgefutures.push_back(std::move(f1));
-                    }
-                    else {
-                        for (int i = 0; i < nw; i++) {
-                            
-                            std::pair<uint, uint> chunk_indexes = {begin, end};
-                            auto f1 = pool.enqueue([&, chunk_indexes, i]() -> int {
-                                return filteringedgework(std::ref(selected_edges), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ), i);
-                            }, std::move(i));
-
-                            filtering_edgefutures.push_back(std::move(f1));
-                            
-                            if (i == nw-2) {
-                                // Last chunk
-                                begin = end;
-                                end = n;
-                            }
-                            else {
-                                begin = end;
-                                end = std::min(begin + chunk_dim, static_cast<size_t>(n));
-                            }
+    std::vector<uint> bounds (nw + 1, n);
 
-                        }
-                    }
+    for (int i = 0; i < nw; i++)
+        bounds[i] = i * chunk_dim;
 
-                    for (auto &fut : filtering_edgefutures) {
-                        int val = fut.get();
-                    }
-    
-                }
+    dispatch_ranges(pool, bounds, work);
 
-                long filtering_node_time;
+}
 
-                std::vector<std::future<int>> filtering_nodefutures;
 
-                {
+/**
+ * @brief Streaming mode: minimum spanning forest of a sliding window over a timestamped edge stream
+ *
+ * The stream is cut into slides of the given length in time units, starting from the time of its first edge,
+ * and the window is made of the last window / slide of them (rounded up). For each number of workers the whole
+ * stream is replayed, the forest of the last window is printed along with the throughput of the slides.
+ */
+int stream_main(const std::string &filename, int num_w, const Options &options) {
 
-                    Utimer timer("Filtering nodes time", &filtering_node_time);
+    uint64_t window = options.getLong("window", 0);
 
-                    uint n = graph.originalNodes;
+    uint64_t slide_length = std::max<long>(options.getLong("slide", window), 1);
 
-                    // Portion of edges for each worker
-                    size_t chunk_dim{ n / nw };
+    uint slides = std::max<uint64_t>((window + slide_length - 1) / slide_length, 1);
 
-                    // The starting index will be at zero
-                    size_t begin = 0;
+    for (int nw = 1; nw <= num_w; nw++) {
 
-                    // The ending one is n if the workers are enough, otherwise the chunk_dim computed before
-                    size_t end = nw != 1 ? std::min(chunk_dim, static_cast<size_t>(n)) : n;
+        EdgeStream stream (filename, options.getLong("seed", 1), options.get("jitter", "0") != "0");
 
-                    if (nw == 1) {
-                        std::pair<uint, uint> chunk_indexes = {begin, end};
-                        auto f1 = pool.enqueue([&, chunk_indexes]() -> int {
-                            return filteringnodework(std::ref(selected_nodes), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ), 0);
-                        }, 0);
+        WindowedMST windowed (slides, nw);
 
-                        filtering_nodefutures.push_back(std::move(f1));
-                    }
-                    else {
-                        for (int i = 0; i < nw; i++) {
-                            
-                            std::pair<uint, uint> chunk_indexes = {begin, end};
-                            auto f1 = pool.enqueue([&, chunk_indexes, i]() -> int {
-                                return filteringnodework(std::ref(selected_nodes), std::ref(initialComponents), std::ref(graph), std::move( chunk_indexes ), i);
-                            }, std::move(i));
-
-                            filtering_nodefutures.push_back(std::move(f1));
-                            
-                            if (i == nw-2) {
-                                // Last chunk
-                                begin = end;
-                                end = n;
-                            }
-                            else {
-                                begin = end;
-                                end = std::min(begin + chunk_dim, static_cast<size_t>(n));
-                            }
+        std::vector<MyEdge> batch;
 
-                        }
-                    }
+        long read_time = 0;
 
-                    for (auto &fut : filtering_nodefutures) {
-                        int val = fut.get();
-                    }
-    
-                }
+        long total_time = 0;
 
-                std::vector<MyEdge> remaining_edges;
-                std::vector<uint> remaining_nodes;
+        size_t edges = 0;
 
-                long filtering_time;
+        int count = 0;
 
-                {
-                    Utimer timer("Final filtering", &filtering_time);
+        uint64_t boundary = stream.nextTime() + slide_length;
+
+        while (!stream.done()) {
+
+            batch.clear();
+
+            long slide_read_time;
+
+            {
+                Utimer timer("Stream reading", &slide_read_time);
+
+                stream.read(boundary, batch);
+            }
+
+            long slide_time;
+
+            {
+                Utimer timer("Slide time", &slide_time);
+
+                windowed.slide(batch);
+            }
+
+            read_time += slide_read_time;
+            total_time += slide_time;
+
+            edges += batch.size();
+
+            boundary += slide_length;
+
+            count++;
+
+        }
+
+        MST mst = windowed.forest();
+
+        print_mst(mst);
+
+        if (options.has("mst"))
+            write_mst(options.get("mst"), mst);
+
+        if (options.has("forest"))
+            write_forest(options.get("forest"), mst);
+
+        std::cout << "workers: " << nw << "; slides: " << count << " of " << slide_length << ", window of " << slides << " slides ("
+                  << windowed.windowEdges() << " edges); edges: " << edges << "; read time " << read_time << " usec; time " << total_time
+                  << " usec; " << static_cast<long>(edges / std::max(total_time * 1e-6, 1e-6)) << " edges/s" << std::endl;
+
+    }
+
+    return (0);
+
+}
+
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 6) {
+        std::cout << "Usage ./[executable] nw number_nodes number_edges filename iters [key=value ...]" << std::endl;
+        return (0);
+    }
+
+    short num_w = std::stoi(argv[1]);
+
+    uint num_nodes = std::atoi(argv[2]);
+
+    uint num_edges = std::atoi(argv[3]);
+
+    std::string filename = std::string(argv[4]);
+
+    int iters = std::atoi(argv[5]);
+
+    Options options(argc, argv, 6);
+
+    if (options.has("window"))
+        return stream_main(filename, num_w, options);
+
+    long loading_time = 0;
+
+    Graph graph;// = Graph();
+
+    // Out-of-core mode: edge budget in MB, spill directory
+    size_t memory = static_cast<size_t>(options.getLong("memory", 0)) << 20;
+
+    std::string spill_dir = options.get("spill", "/tmp");
+
+    bool external = false;
+
+    // Pipelined ingest: minimum edges of the first round, folded while parsing
+    bool pipeline = options.has("pipeline") && options.get("pipeline") != "0";
+
+    std::vector<IdEdge> ingest_minima;
+
+    {
+
+        Utimer read_time("loading graph",&loading_time);
+
+        if (filename.empty()) {
+            graph.generateGraph(num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_generator(filename)) {
+            graph.generateGraph(filename, num_nodes, num_edges, options.getLong("seed", 1));
+        }
+        else if (is_snapshot(filename)) {
+            // Leave the edges on disk if they do not fit in the given budget
+            external = memory > 0 && !ExternalBoruvka(filename, memory, spill_dir, 1).fits();
+            if (external)
+                graph.loadSnapshotNodes(filename);
+            else
+                graph.loadSnapshot(filename);
+        }
+        else {
+            graph.loadGraph(filename, options.get("format", ""), options.getLong("seed", 1), options.get("jitter", "0") != "0", pipeline ? &ingest_minima : NULL);
+        }
+
+    }
+
+    std::cout << "parallel thread; read time: " << loading_time << " usec" << std::endl;
+
+    if (!ingest_minima.empty())
+        std::cout << "parallel thread; minimum edges of the first round computed while loading" << std::endl;
+
+    if (external)
+        std::cout << "parallel thread; edges streamed from disk, memory budget " << (memory >> 20) << " MB" << std::endl;
+
+    if (options.has("save")) {
+        graph.saveSnapshot(options.get("save"));
+        std::cout << "snapshot saved to " << options.get("save") << std::endl;
+    }
+
+    // Batch of edges inserted into the forest found by every run, and the nodes of the graph with them
+    bool inserting = options.has("insert");
+
+    Graph batch;
+
+    std::vector<uint> inserted_nodes;
+
+    uint inserted_original = graph.originalNodes;
+
+    if (inserting) {
+
+        std::string batch_file = options.get("insert");
+
+        if (is_snapshot(batch_file))
+            batch.loadSnapshot(batch_file);
+        else
+            batch.loadGraph(batch_file, options.get("format", ""), options.getLong("seed", 1), options.get("jitter", "0") != "0");
+
+        std::set_union(graph.getNodes().begin(), graph.getNodes().end(), batch.getNodes().begin(), batch.getNodes().end(), std::back_inserter(inserted_nodes));
+
+        inserted_original = std::max(graph.originalNodes, batch.originalNodes);
+
+        std::cout << "parallel thread; " << batch.getNumEdges() << " edges to insert loaded from " << batch_file << std::endl;
+
+    }
+
+    // Compressed mode: the edges are only kept delta encoded, lossy also allows quantizing the weights
+    std::string compress = options.get("compress", "");
+
+    bool compressed = !compress.empty() && compress != "0";
+
+    CompressedEdges compressed_edges;
+
+    if (compressed && !external) {
+        compressed_edges = CompressedEdges::compress(graph.getEdges(), compress == "lossy", default_workers());
+        std::cout << "parallel thread; edges compressed from " << graph.getNumEdges() * sizeof(MyEdge)
+                  << " to " << compressed_edges.memoryBytes() << " bytes" << std::endl;
+        graph.dropEdges();
+    }
+    else {
+        compressed = false;
+    }
+
+    // Surviving compressed edges of the last round, the first round reads the loaded ones
+    CompressedEdges edges;
+
+    // Adjacency mode: the edges are kept as a CSR, both directions of each edge in the rows of its endpoints
+    bool adjacency = options.has("csr") && options.get("csr") != "0" && !external && !compressed;
+
+    CSRGraph adjacency_rows;
+
+    if (adjacency) {
+        long csr_time;
+        {
+            Utimer timer("CSR building", &csr_time);
+            adjacency_rows = CSRGraph(graph.getEdges(), graph.originalNodes, default_workers());
+        }
+        std::cout << "parallel thread; CSR built in " << csr_time << " usec" << std::endl;
+        graph.dropEdges();
+    }
+
+    CSRGraph csr;
+
+    // Vector extension of the kernels of simd.hpp, gathers need node ids below 2^31
+    SimdLevel simd = graph.originalNodes <= INT32_MAX ? parse_simd(options.get("simd", "auto")) : SimdLevel::SCALAR;
+
+    // Structure of arrays mode: the edges are kept as three arrays and filtered with the vector kernels
+    bool soa = options.get("layout", "aos") == "soa" && !external && !compressed && !adjacency;
+
+    EdgeArrays soa_edges;
+
+    if (soa) {
+        soa_edges = EdgeArrays(graph.getEdges(), default_workers());
+        graph.dropEdges();
+    }
+
+    EdgeArrays edge_arrays;
+
+    if (soa || adjacency)
+        std::cout << "parallel thread; " << simd_name(simd) << " kernels" << std::endl;
+
+    // Minimum edge selection: per thread copies merged afterwards (merge) or a shared array updated with a packed write-min (atomic)
+    bool atomic_min = options.get("min", "merge") == "atomic" && !compressed && !adjacency;
+
+    PackedMinima packed_minima (atomic_min ? graph.originalNodes : 0);
+
+    // Filter the edges and find the minimum edges of the next iteration in the same pass over the edge list
+    bool fused = options.has("fused") && options.get("fused") != "0" && !compressed && !adjacency && !soa;
+
+    // Minimum edges found by the fused filter of each thread, merged by the next iteration
+    std::vector<std::vector<IdEdge>> fused_minima;
+
+    // Live edges of each thread in the edges of the view, compacted in place by the fused filter
+    std::vector<std::pair<uint, uint>> segments;
+
+    // MST engine: the Boruvka rounds or Filter-Kruskal, which works on the edges of the graph
+    bool filter_kruskal = options.get("engine", "boruvka") == "filterkruskal" && !external && !compressed && !adjacency && !soa;
+
+    // Contraction engine: concurrent unite() on the lock-free union-find (unionfind) or hooking and pointer jumping (stars)
+    bool star_contraction = options.get("contract", "unionfind") == "stars";
+
+    StarContraction stars;
+
+    // Finish sequentially once the residual graph is small (see finish.hpp): Kruskal below finish edges, the dense pass and
+    // Prim below finish_nodes components, or whichever is estimated cheaper than another round with the calibrated costs (auto)
+    std::string finish = options.get("finish", "0");
+
+    bool finish_auto = finish == "auto";
+
+    size_t finish_edges = finish_auto ? 0 : std::stoull(finish);
+
+    uint finish_nodes = std::min(static_cast<uint>(options.getLong("finish_nodes", 0)), DENSE_FINISH_NODES);
+
+    FinishCosts finish_costs;
+
+    if (finish_auto) {
+        finish_costs = FinishCosts::calibrate();
+        std::cout << "finish calibration: kruskal " << finish_costs.kruskal_us * 1000 << " nsec per edge and bit, dense " << finish_costs.dense_us * 1000 << " nsec per edge, copy "
+                  << finish_costs.copy_us * 1000 << " nsec per edge" << std::endl;
+    }
+
+    CSRGraph next_csr;
+
+    std::vector<char> csr_flags;
+
+    std::vector<uint64_t> csr_kept;
+
+    std::vector<uint> csr_members;
+
+    std::vector<uint64_t> csr_first;
+
+    // The loaded graph is never modified: every run works on a view of it, whose buffers are reused by the next runs
+    GraphView view (graph);
+
+    for (int nw = 1; nw <= num_w; nw++) {
+
+        // Instantiate the threadpool
+        ThreadPool pool (nw);
+
+        // Insertions run on the threads of the pool, with buffers kept across the runs
+        IncrementalMST inserter (pool, nw);
+
+        // External rounds run until the surviving edges fit in memory
+        std::unique_ptr<ExternalBoruvka> external_engine;
+
+        if (external)
+            external_engine.reset(new ExternalBoruvka(filename, memory, spill_dir, nw));
+
+        while (iters > 0) {
+
+            view.reset();
+
+            // Edges of the current round in the compressed, adjacency and structure of arrays modes, the loaded ones first
+            const CompressedEdges *current_blocks = &compressed_edges;
+
+            const CSRGraph *current_rows = &adjacency_rows;
+
+            const EdgeArrays *current_arrays = &soa_edges;
+
+            // Disjoint Union Find structure
+            DisjointSets initialComponents = { static_cast<uint32_t>(view.originalNodes) };
+
+            // Edges added to the spanning tree by each thread
+            MSTRecorder recorder;
+
+            recorder.reset(nw);
+
+            // Dense ids of the components left by each iteration
+            Relabeling relabeling;
+
+            int iter = 0;
+
+            long total_time = 0;
+
+            if (external) {
+                long external_time;
+                iter += external_engine->run(initialComponents, view, external_time, recorder);
+                total_time += external_time;
+            }
+
+            if (filter_kruskal) {
+
+                long filter_kruskal_time;
+
+                {
+                    Utimer timer("Filter-Kruskal time", &filter_kruskal_time);
+
+                    FilterKruskal engine (view.originalNodes, nw);
+
+                    engine.run(view.ownEdges());
+
+                    for (uint id : engine.forestEdges())
+                        recorder.record(0, id);
+
+                    // Each sorted partition counts as an iteration
+                    iter = engine.sortedPartitions();
+                }
+
+                total_time += filter_kruskal_time;
+
+            }
+
+            if (fused) {
+
+                // The segments start as the chunks of dispatch
+                uint chunk_dim = view.getNumEdges() / nw;
+
+                segments.assign(nw, {0, 0});
+                fused_minima.assign(nw, {});
+
+                for (int i = 0; i < nw; i++)
+                    segments[i] = {i * chunk_dim, i + 1 < nw ? (i + 1) * chunk_dim : view.getNumEdges()};
+
+            }
+
+            // Default layout: number of surviving edges of each chunk, the survivors are then written into the buffer of the view
+            // the round is not reading
+            std::vector<size_t> survivors (nw + 1, 0);
+
+            // Minimum edges of each thread and of each node, sized by the first round and only reset by the next ones
+            std::vector<std::vector<IdEdge>> local_edges (nw);
+
+            std::vector<IdEdge> global_edges;
+
+            auto segment_edges = [&]() -> size_t {
+                size_t n = 0;
+                for (auto &segment : segments)
+                    n += segment.second - segment.first;
+                return n;
+            };
+
+            // Edges left: either the compressed list, the adjacency, the edge arrays, the segments or the edges of the graph
+            auto edges_left = [&]() -> size_t { return compressed ? current_blocks->size() : adjacency ? current_rows->numEdges() : soa ? current_arrays->size() : fused ? segment_edges() : view.getNumEdges(); };
+
+            // The minimum edges of the current iteration have been found by the fused filter of the previous one
+            bool carried = false;
+
+            // Residual edges handed to the finish, single copy of each edge with its id
+            auto residual_edges = [&]() -> std::vector<IdEdge> {
+
+                std::vector<IdEdge> residual;
+
+                ArrayRef<MyEdge> edges = view.edges();
+
+                EdgeIds ids = view.ids();
+
+                if (compressed) {
+                    current_blocks->decode(0, current_blocks->numBlocks(), [&residual](const MyEdge &edge, uint id, uint32_t) {
+                        residual.push_back({edge, id});
+                    });
+                }
+                else if (adjacency) {
+                    // Rows come out in node order: back to id order, which breaks the ties of both finishes
+                    residual = current_rows->edgeList();
+                    parallel_radix_sort(residual, [](const IdEdge &edge) { return static_cast<uint64_t>(edge.id); }, 32, nw);
+                }
+                else if (soa) {
+                    for (size_t i = 0; i < current_arrays->size(); i++)
+                        residual.push_back({(*current_arrays)[i], current_arrays->id[i]});
+                }
+                else if (fused) {
+                    for (auto &segment : segments)
+                        for (size_t i = segment.first; i < segment.second; i++)
+                            residual.push_back({edges[i], ids[i]});
+                }
+                else {
+                    residual.resize(edges.size());
+                    for (size_t i = 0; i < edges.size(); i++)
+                        residual[i] = {edges[i], ids[i]};
+                }
+
+                return residual;
+
+            };
+
+            // Time of the last round
+            long round_time = 0;
+
+            // Finish used, the edges and components it got, and the thresholds they were compared to
+            std::string finish_kind;
+
+            size_t finish_residual = 0;
+
+            uint finish_components = 0;
+
+            size_t edge_threshold = finish_edges;
+
+            uint node_threshold = finish_nodes;
+
+            // Bounds of the thread indexes, to hand its own segment to each thread
+            std::vector<uint> threads (nw + 1);
+            std::iota(threads.begin(), threads.end(), 0);
+
+            while (!filter_kruskal && view.getNumNodes() != 1 && edges_left() != 0) {
+
+                size_t residual = edges_left();
+
+                // The dense matrix is indexed by node id
+                uint components = view.originalNodes;
 
-                    for (auto &vect : selected_edges) {
-                        remaining_edges.insert(remaining_edges.end(), vect.begin(), vect.end());
+                bool by_kruskal = residual <= edge_threshold;
+
+                bool by_prim = !by_kruskal && components <= node_threshold;
+
+                if (finish_auto && round_time > 0) {
+
+                    // Largest number of edges Kruskal finishes within the time of the last round
+                    edge_threshold = 0;
+                    for (int bit = 20; bit >= 0; bit--)
+                        if (edge_threshold + (1ULL << bit) <= KRUSKAL_FINISH_EDGES && finish_costs.kruskalTime(edge_threshold + (1ULL << bit)) <= round_time)
+                            edge_threshold += 1ULL << bit;
+
+                    // Largest number of components the dense finish handles within the time of the last round
+                    node_threshold = 0;
+                    for (int bit = 10; bit >= 0; bit--)
+                        if (node_threshold + (1u << bit) <= DENSE_FINISH_NODES && finish_costs.denseTime(residual, node_threshold + (1u << bit), nw) <= round_time)
+                            node_threshold += 1u << bit;
+
+                    double dense_time = finish_costs.denseTime(residual, components, nw);
+
+                    by_kruskal = residual <= edge_threshold && (components > node_threshold || finish_costs.kruskalTime(residual) <= dense_time);
+                    by_prim = !by_kruskal && components <= node_threshold;
+
+                }
+
+                if (by_kruskal || by_prim) {
+
+                    long finish_time;
+
+                    {
+                        Utimer timer("Finish time", &finish_time);
+
+                        std::vector<IdEdge> residual_list = residual_edges();
+
+                        if (by_kruskal) {
+                            kruskal(residual_list, view.originalNodes, [&](const IdEdge &edge) {
+                                recorder.record(0, edge.id);
+                            });
+                        }
+                        else {
+
+                            // Lightest edge between each pair of components in each thread, merged into the first matrix
+                            std::vector<std::vector<uint64_t>> matrices (nw, std::vector<uint64_t>(static_cast<size_t>(components) * components, PackedMinima::EMPTY));
+
+                            dispatch(pool, nw, residual_list.size(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                                dense_minima(residual_list, chunk_indexes.first, chunk_indexes.second, components, matrices[i]);
+                                return 1;
+                            });
+
+                            dispatch(pool, nw, components * components, [&](std::pair<uint, uint> chunk_indexes, int) {
+                                for (int t = 1; t < nw; t++)
+                                    for (uint j = chunk_indexes.first; j < chunk_indexes.second; j++)
+                                        matrices[0][j] = std::min(matrices[0][j], matrices[t][j]);
+                                return 1;
+                            });
+
+                            dense_prim(matrices[0], components, [&](uint index) {
+                                recorder.record(0, residual_list[index].id);
+                            });
+
+                        }
                     }
 
-                    for (auto &vect : selected_nodes) {
-                        remaining_nodes.insert(remaining_nodes.end(), vect.begin(), vect.end());
+                    total_time += finish_time;
+
+                    finish_kind = by_kruskal ? "kruskal" : "prim";
+                    finish_residual = residual;
+                    finish_components = components;
+
+                    break;
+
+                }
+
+                long map_time = 0;
+
+                long merge_time = 0;
+
+                // The minimum edges are in the packed slots rather than in global_edges
+                bool packed = false;
+
+                if (iter == 0 && !ingest_minima.empty()) {
+                    // The first solve after a pipelined ingest finds the minimum edges already computed
+                    global_edges.swap(ingest_minima);
+                    ingest_minima.clear();
+                }
+                else if (carried && atomic_min) {
+                    // The slots have been filled by the fused filter of the previous iteration
+                    packed = true;
+                }
+                else if (adjacency) {
+
+                    // Each row is reduced by a single thread, no local copies to merge
+                    Utimer timer("Map parallel time", &map_time);
+
+                    global_edges.assign(view.originalNodes, {0, 0, MAX_WEIGHT});
+
+                    dispatch_ranges(pool, current_rows->balancedRows(nw), [&](std::pair<uint, uint> chunk_indexes, int) {
+                        return csrmapwork(global_edges, *current_rows, chunk_indexes, simd);
+                    });
+
+                }
+                else if (atomic_min) {
+
+                    // All the threads write into the same slots, no local copies to merge
+                    Utimer timer("Map parallel time", &map_time);
+
+                    dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int) {
+                        packed_minima.reset(chunk_indexes.first, chunk_indexes.second);
+                        return 1;
+                    });
+
+                    if (soa) {
+                        dispatch(pool, nw, current_arrays->size(), [&](std::pair<uint, uint> chunk_indexes, int) {
+                            return atomicmapwork(packed_minima, *current_arrays, chunk_indexes);
+                        });
+                    }
+                    else {
+                        dispatch(pool, nw, view.getNumEdges(), [&](std::pair<uint, uint> chunk_indexes, int) {
+                            return atomicmapwork(packed_minima, view.edges(), chunk_indexes);
+                        });
                     }
 
+                    packed = true;
+
                 }
+                else {
+
+                    {
+
+                        Utimer timer("Map parallel time", &map_time);
+
+                        if (carried) {
+                            // Found by the fused filter of the previous iteration
+                            local_edges.swap(fused_minima);
+                        }
+                        else if (compressed) {
+                            dispatch(pool, nw, current_blocks->numBlocks(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                                return compressedmapwork(local_edges, *current_blocks, view.originalNodes, chunk_indexes, i);
+                            });
+                        }
+                        else if (soa) {
+                            dispatch(pool, nw, current_arrays->size(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                                return soamapwork(local_edges, *current_arrays, view.originalNodes, chunk_indexes, i);
+                            });
+                        }
+                        else {
+                            dispatch(pool, nw, view.getNumEdges(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                                return mapwork(local_edges, view, chunk_indexes, i);
+                            });
+                        }
+
+                    }
+
+                    {
+
+                        Utimer timer("Merge time", &merge_time);
+
+                        global_edges.assign(view.originalNodes, {0, 0, MAX_WEIGHT});
+
+                        dispatch(pool, nw, local_edges[0].size(), [&](std::pair<uint, uint> chunk_indexes, int) {
+                            return mergework(local_edges, global_edges, chunk_indexes);
+                        });
+
+                    }
+
+                }
+
+                long contraction_time;
+
+                // Edges added to the spanning forest by the contraction
+                size_t merged;
+
+                {
+
+                    Utimer timer("Contraction time", &contraction_time);
+
+                    if (star_contraction) {
+
+                        stars.reset(view.originalNodes);
+
+                        auto hook = [&](auto minEdge) {
+                            dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int) {
+                                return hookingwork(stars, minEdge, chunk_indexes);
+                            });
+                        };
+
+                        if (packed && soa)
+                            hook([&](uint node) { return packed_minima.edgeOf(node, *current_arrays, current_arrays->id.data()); });
+                        else if (packed)
+                            hook([&](uint node) { return packed_minima.edgeOf(node, view.edges(), view.ids()); });
+                        else
+                            hook([&](uint node) { return global_edges[node]; });
+
+                        dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return cyclework(stars, recorder, chunk_indexes, i);
+                        });
+
+                        stars.swap();
+
+                        std::vector<char> moved (nw, 1);
+
+                        while (std::count(moved.begin(), moved.end(), 1) > 0) {
+
+                            dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                                return jumpingwork(stars, moved, chunk_indexes, i);
+                            });
+
+                            stars.swap();
+
+                        }
+
+                    }
+                    else if (packed && soa) {
+                        dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return atomiccontractionwork(packed_minima, initialComponents, *current_arrays, current_arrays->id.data(), recorder, chunk_indexes, i);
+                        });
+                    }
+                    else if (packed) {
+                        dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return atomiccontractionwork(packed_minima, initialComponents, view.edges(), view.ids(), recorder, chunk_indexes, i);
+                        });
+                    }
+                    else {
+                        dispatch(pool, nw, global_edges.size(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return contractionwork(global_edges, initialComponents, view, recorder, chunk_indexes, i);
+                        });
+                    }
+
+                    merged = recorder.endRound();
+    
+                }
+
+                // Nothing to contract although edges are left (e.g. NaN weights, never picked): the next rounds would be the same
+                if (merged == 0) {
+                    total_time += map_time + merge_time + contraction_time;
+                    break;
+                }
+
+                long filtering_node_time;
+
+                {
+
+                    Utimer timer("Filtering nodes time", &filtering_node_time);
+
+                    // The parent nodes are numbered densely: count them in each chunk, then number them from the prefix sum of the counts
+                    auto relabel_nodes = [&](auto &components) {
+
+                        relabeling.reset(view.originalNodes, nw);
+
+                        dispatch(pool, nw, view.getNumNodes(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return filteringnodework(relabeling, components, view, chunk_indexes, i);
+                        });
 
-                total_time += map_time + merge_time + contraction_time + filtering_edge_time + filtering_node_time + filtering_time; 
+                        relabeling.prefixSum();
 
-                graph.updateNodes(std::ref(remaining_nodes));
-                graph.updateEdges(std::ref(remaining_edges));
+                        dispatch(pool, nw, view.getNumNodes(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return labelingwork(relabeling, components, view, chunk_indexes, i);
+                        });
+
+                        dispatch(pool, nw, view.originalNodes, [&](std::pair<uint, uint> chunk_indexes, int) {
+                            return flatteningwork(relabeling, components, chunk_indexes);
+                        });
+
+                    };
+
+                    if (star_contraction)
+                        relabel_nodes(stars);
+                    else
+                        relabel_nodes(initialComponents);
+    
+                }
+
+                long filtering_edge_time;
+
+                std::vector<CompressedEdges> selected_blocks (compressed ? nw : 0);
+
+                std::vector<EdgeArrays> selected_arrays (soa ? nw : 0);
+
+                {
+
+                    Utimer timer("Filtering edges time", &filtering_edge_time);
+
+                    if (compressed) {
+                        dispatch(pool, nw, current_blocks->numBlocks(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return compressedfilterwork(selected_blocks, relabeling, *current_blocks, chunk_indexes, i);
+                        });
+                    }
+                    else if (adjacency) {
+
+                        std::vector<uint> rows = current_rows->balancedRows(nw);
+
+                        uint components = relabeling.numLabels();
+
+                        // Every edge appears in two rows: the flattened component of each node is loaded instead of two find() walks
+                        const std::vector<uint> &labels = relabeling.component;
+
+                        csr_flags.resize(current_rows->numEntries());
+                        csr_kept.resize(current_rows->numRows());
+
+                        dispatch_ranges(pool, rows, [&](std::pair<uint, uint> chunk_indexes, int) {
+                            current_rows->countRows(chunk_indexes.first, chunk_indexes.second, [&](uint node) {
+                                return labels[node];
+                            }, csr_flags, csr_kept);
+                            return 1;
+                        });
+
+                        // The rows of each component are merged into one row of the contracted adjacency
+                        CSRGraph::groupRows(labels, csr_kept, components, csr_members, csr_first, nw);
+
+                        // Kept entries of each range of components, then their prefix sum
+                        std::vector<uint64_t> kept (nw + 1, 0);
+
+                        dispatch(pool, nw, components, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            kept[i+1] = CSRGraph::countGroups(chunk_indexes.first, chunk_indexes.second, csr_members, csr_first, csr_kept);
+                            return 1;
+                        });
+
+                        for (int i = 0; i < nw; i++)
+                            kept[i+1] += kept[i];
+
+                        next_csr.offsets.assign(static_cast<size_t>(components) + 1, 0);
+                        next_csr.neighbours.resize(kept[nw]);
+                        next_csr.weights.resize(kept[nw]);
+                        next_csr.ids.resize(kept[nw]);
+
+
+                        dispatch(pool, nw, components, [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            current_rows->gatherRows(chunk_indexes.first, chunk_indexes.second, kept[i], csr_members, csr_first, csr_flags, labels, next_csr);
+                            return 1;
+                        });
+
+                    }
+                    else if (soa) {
+
+                        // The kernels gather the flattened components of both endpoints of every edge
+                        dispatch(pool, nw, current_arrays->size(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return soafilterwork(selected_arrays, *current_arrays, relabeling.component, simd, chunk_indexes, i);
+                        });
+
+                    }
+                    else if (fused && atomic_min) {
+
+                        // The slots of the new ids are emptied before any thread offers into them
+                        dispatch(pool, nw, relabeling.numLabels(), [&](std::pair<uint, uint> chunk_indexes, int) {
+                            packed_minima.reset(chunk_indexes.first, chunk_indexes.second);
+                            return 1;
+                        });
+
+                        EdgeBuffer &next_edges = view.survivors(view.getNumEdges(), true);
+
+                        IdBuffer &next_ids = view.survivorIds();
+
+                        dispatch_ranges(pool, threads, [&](std::pair<uint, uint>, int i) {
+                            return fusedfilterwork(segments, relabeling, view, next_edges, next_ids, i, [&](const MyEdge &edge, uint position) {
+                                packed_minima.offerEdge(edge, position);
+                            });
+                        });
+
+                    }
+                    else if (fused) {
+
+                        EdgeBuffer &next_edges = view.survivors(view.getNumEdges(), true);
+
+                        IdBuffer &next_ids = view.survivorIds();
+
+                        dispatch_ranges(pool, threads, [&](std::pair<uint, uint>, int i) {
+
+                            std::vector<IdEdge> &local = fused_minima[i];
+                            local.assign(relabeling.numLabels(), {0, 0, MAX_WEIGHT});
+
+                            // The id of the survivor has just been written next to it
+                            return fusedfilterwork(segments, relabeling, view, next_edges, next_ids, i, [&](const MyEdge &edge, uint position) {
+                                offer_edge(local, edge, next_ids.data(), position);
+                            });
+                        });
+
+                    }
+                    else {
+                        dispatch(pool, nw, view.getNumEdges(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return countingwork(survivors, relabeling, view, chunk_indexes, i);
+                        });
+
+                        for (int i = 0; i < nw; i++)
+                            survivors[i + 1] += survivors[i];
+
+                        EdgeBuffer &next_edges = view.survivors(survivors[nw]);
+
+                        IdBuffer &next_ids = view.survivorIds();
+
+                        dispatch(pool, nw, view.getNumEdges(), [&](std::pair<uint, uint> chunk_indexes, int i) {
+                            return filteringedgework(next_edges, next_ids, survivors, relabeling, view, chunk_indexes, i);
+                        });
+                    }
+    
+                }
+
+                long filtering_time;
+
+                {
+                    Utimer timer("Final filtering", &filtering_time);
+
+                    if (compressed) {
+                        edges = CompressedEdges::concat(selected_blocks);
+                        current_blocks = &edges;
+                    }
+                    else if (adjacency) {
+                        std::swap(csr, next_csr);
+                        current_rows = &csr;
+                    }
+                    else if (soa) {
+                        // The survivors have been copied out, the arrays are refilled within their capacity
+                        edge_arrays.resize(0);
+                        for (auto &arrays : selected_arrays) {
+                            edge_arrays.append(arrays);
+                        }
+                        current_arrays = &edge_arrays;
+                    }
+                    else {
+                        // The surviving edges are already in place in the segments, or in the buffer of the survivors
+                        view.useSurvivors();
+                    }
+
+                }
+
+                round_time = map_time + merge_time + contraction_time + filtering_edge_time + filtering_node_time + filtering_time;
+
+                total_time += round_time;
+
+                // The next iteration works on the new ids of the components
+                view.renumberNodes(relabeling.numLabels());
+
+                carried = fused;
+
+                if (!star_contraction)
+                    initialComponents = DisjointSets(view.originalNodes);
 
                 iter++;
 
             }   
 
-            std::cout << "workers: " << nw << "; iters: " << iter << "; time " << total_time << " usec" << std::endl;
+            MST mst;
+
+            long mst_time;
+
+            {
+                Utimer timer("MST time", &mst_time);
+
+                // The recorded ids are positions in the loaded edges, in whatever form they are kept
+                if (external) {
+                    Snapshot snapshot (filename);
+                    mst = recorder.resolve(snapshot.edges());
+                }
+                else if (compressed) {
+                    mst = recorder.resolveScan(compressed_edges.size(), [&](auto f) {
+                        compressed_edges.decode(0, compressed_edges.numBlocks(), [&f](const MyEdge &edge, uint id, uint32_t) { f(edge, id); });
+                    });
+                }
+                else if (adjacency) {
+                    mst = recorder.resolveScan(adjacency_rows.numEdges(), [&](auto f) { adjacency_rows.forEachEdge(f); });
+                }
+                else if (soa) {
+                    mst = recorder.resolve(soa_edges);
+                }
+                else {
+                    mst = recorder.resolve(graph.getEdges());
+                }
+
+                mst.findTrees(graph.getNodes(), graph.originalNodes);
+            }
+
+            if (!finish_kind.empty())
+                std::cout << "finish: " << finish_kind << " on " << finish_residual << " edges, " << finish_components << " components; thresholds "
+                          << edge_threshold << " edges, " << node_threshold << " components" << std::endl;
+
+            print_mst(mst);
+
+            // The tree is resolved once the rounds are over, its time is not part of the time of the algorithm
+            std::cout << "workers: " << nw << "; iters: " << iter << "; time " << total_time << " usec; mst time " << mst_time << " usec" << std::endl;
+
+            if (inserting) {
+
+                long insert_time;
+
+                int rounds;
+
+                {
+                    Utimer timer("Insertion time", &insert_time);
+
+                    rounds = inserter.insert(mst, batch.getEdges());
+
+                    mst.findTrees(inserted_nodes, inserted_original);
+                }
+
+                print_mst(mst);
+
+                std::cout << "workers: " << nw << "; inserted " << batch.getNumEdges() << " edges; iters: " << rounds << "; time " << insert_time << " usec" << std::endl;
+
+            }
+
+            if (options.has("mst"))
+                write_mst(options.get("mst"), mst);
 
-            graph = copy_graph;
+            if (options.has("forest"))
+                write_forest(options.get("forest"), mst);
 
             iters--;
 
@@ -0,0 +1,364 @@
+#if !defined(__COMPRESSED_H)
+#define __COMPRESSED_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "utils.hpp"
+#include "sort.hpp"
+#include "parallel.hpp"
+
+// Maximum number of edges of a block
+#define BLOCK_EDGES 128
+
+/**
+ * @brief How the weights of a compressed edge list are stored
+ *
+ * - RAW: 32 bit floats
+ * - DICTIONARY: 16 bit index into the sorted table of the distinct weights (exact, at most 65536 distinct weights)
+ * - QUANTIZED: 16 bit index into 65536 evenly spaced levels between the minimum and maximum weight (lossy)
+ */
+enum class WeightCoding { RAW, DICTIONARY, QUANTIZED };
+
+
+/**
+ * @brief Compressed edge list
+ *
+ * Edges are best sorted by (from, to), as the edge vector of the Graph is. They are split into blocks of at
+ * most BLOCK_EDGES edges and the endpoints of each block are delta encoded as variable length integers:
+ *
+ *  - first edge of a block: from, to, id
+ *  - next edges: from - previous from, then to - previous to if the starting node did not change, to otherwise,
+ *    then id - previous id (ids only grow along a list, filtered lists keep the order of the edges)
+ *
+ * The differences are zigzag encoded, so that a step back costs as many bytes as a step forward of the same size.
+ *
+ * Every block can be decoded on its own, so workers can decode disjoint ranges of blocks, and compressed
+ * lists can be concatenated block by block. Weights are stored apart, one per edge, either raw or as 16 bit
+ * codes into a table. Codes are ordered like the weights they stand for.
+ */
+class CompressedEdges {
+
+    public:
+
+        CompressedEdges() : coding(WeightCoding::RAW), block_offset(1, 0), block_first(1, 0) {}
+
+        // Number of edges
+        size_t size() const { return block_first.back(); }
+
+        // Number of blocks
+        size_t numBlocks() const { return block_first.size() - 1; }
+
+        // Memory used by the encoded edges, in bytes
+        size_t memoryBytes() const {
+            return bytes.size() + (block_offset.size() + block_first.size()) * sizeof(uint64_t)
+                + codes.size() * sizeof(uint16_t) + raw.size() * sizeof(float) + dictionary.size() * sizeof(float);
+        }
+
+        WeightCoding weightCoding() const { return coding; }
+
+        /**
+         * @brief Compress a sorted edge list
+         *
+         * @param edges the loaded edges, sorted by (from, to), whose ids are their positions
+         * @param lossy if the weights cannot be dictionary coded, quantize them instead of storing them raw
+         * @param nw number of workers
+         */
+        static CompressedEdges compress(ArrayRef<MyEdge> edges, bool lossy, uint nw) {
+
+            CompressedEdges table;
+
+            table.chooseCoding(edges, lossy, nw);
+
+            std::vector<CompressedEdges> parts (nw);
+
+            parallel_chunks(edges.size(), nw, [&](size_t begin, size_t end, uint thid) {
+                parts[thid].inheritCoding(table);
+                for (size_t i = begin; i < end; i++)
+                    parts[thid].append(edges[i].from, edges[i].to, static_cast<uint>(i), table.encodeWeight(edges[i].weight));
+            });
+
+            return concat(parts);
+
+        }
+
+        /**
+         * @brief Concatenate compressed lists sharing the same weight coding
+         */
+        static CompressedEdges concat(std::vector<CompressedEdges> &parts) {
+
+            CompressedEdges result;
+
+            if (parts.empty())
+                return result;
+
+            result.inheritCoding(parts[0]);
+
+            size_t total_bytes = 0, total_edges = 0, total_blocks = 0;
+
+            for (auto &part : parts) {
+                total_bytes += part.bytes.size();
+                total_edges += part.size();
+                total_blocks += part.numBlocks();
+            }
+
+            result.bytes.reserve(total_bytes);
+            result.block_offset.reserve(total_blocks + 1);
+            result.block_first.reserve(total_blocks + 1);
+            (result.coding == WeightCoding::RAW ? result.raw.reserve(total_edges) : result.codes.reserve(total_edges));
+
+            for (auto &part : parts) {
+
+                uint64_t byte_base = result.bytes.size();
+                uint64_t edge_base = result.size();
+
+                result.bytes.insert(result.bytes.end(), part.bytes.begin(), part.bytes.end());
+
+                for (size_t b = 1; b <= part.numBlocks(); b++) {
+                    result.block_offset.push_back(byte_base + part.block_offset[b]);
+                    result.block_first.push_back(edge_base + part.block_first[b]);
+                }
+
+                result.codes.insert(result.codes.end(), part.codes.begin(), part.codes.end());
+                result.raw.insert(result.raw.end(), part.raw.begin(), part.raw.end());
+
+            }
+
+            result.open = 0;
+
+            return result;
+
+        }
+
+        /**
+         * @brief Create an empty list with the same weight coding as the given one
+         */
+        void inheritCoding(const CompressedEdges &other) {
+            coding = other.coding;
+            dictionary = other.dictionary;
+            low = other.low;
+            scale = other.scale;
+        }
+
+        /**
+         * @brief Append an edge, whose weight has already been encoded with encodeWeight (or taken from another list)
+         *
+         * Edges are best appended in (from, to) order, but any order works: the survivors of a round, relabeled
+         * over the new ids of their components, are not sorted by starting node, and each step back only takes
+         * the bytes of its zigzag encoded difference.
+         */
+        void append(uint from, uint to, uint id, uint32_t weight) {
+
+            if (open == 0) {
+                // Start a new block: the sentinels of the last block become the start of the new one
+                block_offset.push_back(bytes.size());
+                block_first.push_back(block_first.back());
+                put(from);
+                put(to);
+                put(id);
+            }
+            else {
+                put(zigzag(from - last_from));
+                put(from == last_from ? zigzag(to - last_to) : to);
+                put(id - last_id);
+            }
+
+            last_from = from;
+            last_to = to;
+            last_id = id;
+
+            if (coding == WeightCoding::RAW) {
+                float value;
+                memcpy(&value, &weight, sizeof(value));
+                raw.push_back(value);
+            }
+            else {
+                codes.push_back(static_cast<uint16_t>(weight));
+            }
+
+            block_offset.back() = bytes.size();
+            block_first.back()++;
+
+            if (++open == BLOCK_EDGES)
+                open = 0;
+
+        }
+
+        /**
+         * @brief Encode a weight according to the coding of the list
+         */
+        uint32_t encodeWeight(float weight) const {
+
+            switch (coding) {
+
+                case WeightCoding::DICTIONARY:
+                    return std::lower_bound(dictionary.begin(), dictionary.end(), weight) - dictionary.begin();
+
+                case WeightCoding::QUANTIZED: {
+                    double level = scale > 0 ? (weight - low) / scale : 0;
+                    return static_cast<uint32_t>(std::min(std::max(level + 0.5, 0.0), 65535.0));
+                }
+
+                default: {
+                    uint32_t bits;
+                    memcpy(&bits, &weight, sizeof(bits));
+                    return bits;
+                }
+
+            }
+
+        }
+
+        /**
+         * @brief Decode the edges of the blocks [first_block, last_block)
+         *
+         * @tparam F function type, called as f(edge, id, weight_code) for every edge in order, where weight_code
+         *           is the encoded weight, to be passed to append when the edge is copied to another list
+         */
+        template <typename F>
+        void decode(size_t first_block, size_t last_block, F f) const {
+
+            for (size_t b = first_block; b < last_block; b++) {
+
+                const uint8_t *p = bytes.data() + block_offset[b];
+
+                uint64_t first = block_first[b];
+                uint64_t last = block_first[b+1];
+
+                uint from = get(p);
+                uint to = get(p);
+                uint id = get(p);
+
+                for (uint64_t i = first; i < last; i++) {
+
+                    if (i != first) {
+                        uint delta = unzigzag(get(p));
+                        uint value = get(p);
+                        to = delta == 0 ? to + unzigzag(value) : value;
+                        from += delta;
+                        id += get(p);
+                    }
+
+                    MyEdge edge;
+                    edge.from = from;
+                    edge.to = to;
+
+                    uint32_t code;
+
+                    if (coding == WeightCoding::RAW) {
+                        edge.weight = raw[i];
+                        memcpy(&code, &edge.weight, sizeof(code));
+                    }
+                    else {
+                        code = codes[i];
+                        edge.weight = dictionary[code];
+                    }
+
+                    f(edge, id, code);
+
+                }
+
+            }
+
+        }
+
+    private:
+
+        WeightCoding coding;
+
+        // Variable length encoded endpoints and ids
+        std::vector<uint8_t> bytes;
+
+        // Byte offset and index of the first edge of each block, plus a sentinel
+        std::vector<uint64_t> block_offset;
+        std::vector<uint64_t> block_first;
+
+        // Weights, either codes or raw values
+        std::vector<uint16_t> codes;
+        std::vector<float> raw;
+
+        // Weight of each code, increasing
+        std::vector<float> dictionary;
+
+        // Quantization parameters
+        double low = 0;
+        double scale = 0;
+
+        // Edges in the block being written, and last endpoints written
+        uint open = 0;
+        uint last_from = 0;
+        uint last_to = 0;
+        uint last_id = 0;
+
+        // Map the difference of two ids, taken as a signed value, to an unsigned one: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+        static uint zigzag(uint delta) {
+            return (delta << 1) ^ static_cast<uint>(static_cast<int32_t>(delta) >> 31);
+        }
+
+        // Inverse of zigzag
+        static uint unzigzag(uint value) {
+            return (value >> 1) ^ (0u - (value & 1));
+        }
+
+        // Write a variable length integer, 7 bits per byte
+        void put(uint value) {
+            while (value >= 0x80) {
+                bytes.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            bytes.push_back(static_cast<uint8_t>(value));
+        }
+
+        // Read a variable length integer
+        static uint get(const uint8_t *&p) {
+            uint value = *p++;
+            if (value < 0x80)
+                return value;
+            value &= 0x7F;
+            for (int shift = 7; ; shift += 7) {
+                uint byte = *p++;
+                value |= (byte & 0x7F) << shift;
+                if (byte < 0x80)
+                    return value;
+            }
+        }
+
+        /**
+         * @brief Pick the weight coding: a dictionary if there are at most 65536 distinct weights,
+         * otherwise quantization if lossy compression is allowed, raw floats if not
+         */
+        void chooseCoding(ArrayRef<MyEdge> edges, bool lossy, uint nw) {
+
+            std::vector<float> weights (edges.size());
+
+            parallel_chunks(edges.size(), nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++)
+                    weights[i] = edges[i].weight;
+            });
+
+            parallel_radix_sort(weights, [](float w) { return static_cast<uint64_t>(weight_key(w)); }, 32, nw);
+
+            parallel_compact(weights, [&weights](size_t i) { return i == 0 || weights[i] != weights[i-1]; }, nw);
+
+            if (weights.size() <= 65536) {
+                coding = WeightCoding::DICTIONARY;
+                dictionary = weights;
+            }
+            else if (lossy) {
+                coding = WeightCoding::QUANTIZED;
+                low = weights.front();
+                scale = (static_cast<double>(weights.back()) - low) / 65535;
+                dictionary.resize(65536);
+                for (uint k = 0; k < 65536; k++)
+                    dictionary[k] = static_cast<float>(low + k * scale);
+            }
+            else {
+                coding = WeightCoding::RAW;
+            }
+
+        }
+
+};
+
+#endif
@@ -0,0 +1,334 @@
+#if !defined(__CSR_H)
+#define __CSR_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include "utils.hpp"
+#include "parallel.hpp"
+#include "sort.hpp"
+#include "simd.hpp"
+
+/**
+ * @brief Compressed sparse row adjacency of an undirected graph
+ *
+ * Row v holds the neighbours of node v and the weights and ids of the edges towards them, in increasing
+ * neighbour order: entries offsets[v] to offsets[v+1] of the neighbours, weights and ids arrays. Every undirected edge
+ * appears in the rows of both its endpoints.
+ *
+ * The minimum edge of a node is then a reduction over a contiguous segment. At the end of a round the
+ * adjacency is contracted: the rows of each component are merged into a single row, numbered with the dense
+ * id of the component (see relabel.hpp), keeping only the entries that cross two components. Entries are
+ * counted row by row, the rows are grouped by component, and the kept entries are copied at the prefix sum
+ * of the counts of the components, each pass run by the workers on disjoint ranges of rows.
+ */
+class CSRGraph {
+
+    public:
+
+        // Row offsets, one per node plus a sentinel
+        std::vector<uint64_t> offsets;
+
+        // Entries of the rows, left uninitialized by a resize: the contractions write them right after sizing them
+        std::vector<uint, uninitialized_allocator<uint>> neighbours;
+
+        std::vector<float, uninitialized_allocator<float>> weights;
+
+        std::vector<uint, uninitialized_allocator<uint>> ids;
+
+        CSRGraph() : offsets(1, 0) {}
+
+        /**
+         * @brief Build the adjacency from the single copy of each undirected edge
+         *
+         * @param edges the loaded edges, with from > to, sorted by (from, to), no duplicates (as stored by the Graph): their ids are
+         *        their positions
+         * @param numNodes size of the node id range
+         * @param nw number of workers
+         *
+         * Row v is made of the edges starting from v, whose neighbours are lower than v and already sorted,
+         * followed by the edges ending in v, whose neighbours are higher. The latter are obtained with a stable
+         * radix sort of the edges on the ending node only.
+         */
+        CSRGraph(ArrayRef<MyEdge> edges, uint numNodes, uint nw) {
+
+            size_t m = edges.size();
+
+            int node_bits = 0;
+            while (node_bits < 32 && (static_cast<uint64_t>(numNodes) >> node_bits) != 0)
+                node_bits++;
+
+            // The sort moves the edges away from their positions, they take their ids along
+            std::vector<IdEdge> reversed (m);
+
+            parallel_chunks(m, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++)
+                    reversed[i] = {edges[i], static_cast<uint>(i)};
+            });
+
+            parallel_radix_sort(reversed, [](const IdEdge &edge) { return static_cast<uint64_t>(edge.to); }, node_bits, nw);
+
+            // First edge of each row in the two lists
+            std::vector<uint64_t> lower (static_cast<size_t>(numNodes) + 1);
+            std::vector<uint64_t> higher (static_cast<size_t>(numNodes) + 1);
+
+            row_starts(edges, numNodes, nw, [](const MyEdge &edge) { return edge.from; }, lower);
+            row_starts(reversed, numNodes, nw, [](const IdEdge &edge) { return edge.to; }, higher);
+
+            offsets.resize(static_cast<size_t>(numNodes) + 1);
+
+            parallel_chunks(static_cast<size_t>(numNodes) + 1, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t row = begin; row < end; row++)
+                    offsets[row] = lower[row] + higher[row];
+            });
+
+            neighbours.resize(2 * m);
+            weights.resize(2 * m);
+            ids.resize(2 * m);
+
+            parallel_chunks(m, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+
+                    uint row = edges[i].from;
+                    uint64_t position = offsets[row] + (i - lower[row]);
+                    neighbours[position] = edges[i].to;
+                    weights[position] = edges[i].weight;
+                    ids[position] = static_cast<uint>(i);
+
+                    row = reversed[i].to;
+                    position = offsets[row] + (lower[row+1] - lower[row]) + (i - higher[row]);
+                    neighbours[position] = reversed[i].from;
+                    weights[position] = reversed[i].weight;
+                    ids[position] = reversed[i].id;
+
+                }
+            });
+
+        }
+
+        uint numRows() const { return offsets.size() - 1; }
+
+        uint64_t numEntries() const { return offsets.back(); }
+
+        // Number of undirected edges
+        uint64_t numEdges() const { return offsets.back() / 2; }
+
+        /**
+         * @brief Call f(edge, id) on a single copy of each undirected edge, from > to, taken from the row of its higher endpoint
+         */
+        template <typename F>
+        void forEachEdge(F f) const {
+
+            for (uint row = 0; row < numRows(); row++)
+                for (uint64_t i = offsets[row]; i < offsets[row+1]; i++)
+                    if (neighbours[i] < row)
+                        f(MyEdge{row, neighbours[i], weights[i]}, ids[i]);
+
+        }
+
+        /**
+         * @brief Single copy of each undirected edge with its id, from > to, taken from the row of its higher endpoint
+         */
+        std::vector<IdEdge> edgeList() const {
+
+            std::vector<IdEdge> edges;
+
+            edges.reserve(numEdges());
+
+            forEachEdge([&edges](const MyEdge &edge, uint id) { edges.push_back({edge, id}); });
+
+            return edges;
+
+        }
+
+        /**
+         * @brief Split the rows among nw workers, so that each one gets about the same number of entries
+         *
+         * @return std::vector<uint> the nw+1 bounds of the row ranges
+         */
+        std::vector<uint> balancedRows(uint nw) const {
+
+            std::vector<uint> bounds (nw + 1, numRows());
+
+            bounds[0] = 0;
+
+            for (uint i = 1; i < nw; i++) {
+                uint64_t target = numEntries() / nw * i;
+                bounds[i] = std::lower_bound(offsets.begin(), offsets.end() - 1, target) - offsets.begin();
+            }
+
+            return bounds;
+
+        }
+
+        /**
+         * @brief Compute the minimum edge of the rows [begin, end)
+         *
+         * @param minima minimum edge of each node, the entries of the rows are overwritten
+         * @param simd vector extension of the row scan (see simd.hpp)
+         *
+         * Ties go to the lowest edge id, as in lighter()
+         */
+        void rowMinima(uint begin, uint end, std::vector<IdEdge> &minima, SimdLevel simd = SimdLevel::SCALAR) const {
+
+            for (uint row = begin; row < end; row++) {
+
+                float weight;
+                uint neighbour, id;
+
+                segment_min(simd, weights.data() + offsets[row], neighbours.data() + offsets[row], ids.data() + offsets[row], offsets[row+1] - offsets[row],
+                            weight, neighbour, id);
+
+                minima[row] = weight == MAX_WEIGHT ? IdEdge{0, 0, MAX_WEIGHT} : IdEdge{row, neighbour, weight, id};
+
+            }
+
+        }
+
+        /**
+         * @brief First filtering pass: mark the entries of the rows [begin, end) that cross two components and count them
+         *
+         * @param label function called as label(node), returning the id of the component of node
+         * @param flags one flag per entry, set if the entry is kept
+         * @param kept receives the number of kept entries of each row
+         *
+         * The component of the row is looked up once for all its entries
+         */
+        template <typename LabelF>
+        void countRows(uint begin, uint end, LabelF label, std::vector<char> &flags, std::vector<uint64_t> &kept) const {
+
+            for (uint row = begin; row < end; row++) {
+
+                uint64_t count = 0;
+
+                if (offsets[row] != offsets[row+1]) {
+
+                    uint row_label = label(row);
+
+                    for (uint64_t i = offsets[row]; i < offsets[row+1]; i++) {
+                        flags[i] = label(neighbours[i]) != row_label;
+                        count += flags[i];
+                    }
+
+                }
+
+                kept[row] = count;
+
+            }
+
+        }
+
+        /**
+         * @brief Group the rows with kept entries by component, each component becomes a row of the contracted adjacency
+         *
+         * @param labels id of the component of each row, from 0 to numLabels-1
+         * @param kept number of kept entries of each row, rows without any are left out
+         * @param members receives the rows sorted by component, increasing within a component
+         * @param first receives numLabels+1 entries, the rows of component c are members[first[c]] to members[first[c+1]]
+         * @param nw number of workers
+         */
+        static void groupRows(const std::vector<uint> &labels, const std::vector<uint64_t> &kept, uint numLabels,
+                              std::vector<uint> &members, std::vector<uint64_t> &first, uint nw) {
+
+            int label_bits = 0;
+            while (label_bits < 32 && (static_cast<uint64_t>(numLabels) >> label_bits) != 0)
+                label_bits++;
+
+            members.resize(kept.size());
+            std::iota(members.begin(), members.end(), 0);
+
+            parallel_compact(members, [&kept](size_t row) { return kept[row] != 0; }, nw);
+
+            parallel_radix_sort(members, [&labels](uint row) { return static_cast<uint64_t>(labels[row]); }, label_bits, nw);
+
+            first.resize(static_cast<size_t>(numLabels) + 1);
+
+            row_starts(members, numLabels, nw, [&labels](uint row) { return labels[row]; }, first);
+
+        }
+
+        /**
+         * @brief Second filtering pass: count the kept entries of the components [begin, end)
+         *
+         * @return uint64_t the number of entries of the contracted rows [begin, end)
+         */
+        static uint64_t countGroups(uint begin, uint end, const std::vector<uint> &members, const std::vector<uint64_t> &first, const std::vector<uint64_t> &kept) {
+
+            uint64_t total = 0;
+
+            for (uint64_t i = first[begin]; i < first[end]; i++)
+                total += kept[members[i]];
+
+            return total;
+
+        }
+
+        /**
+         * @brief Third filtering pass: copy the marked entries of the rows of the components [begin, end) into the contracted adjacency
+         *
+         * @param position position in next of the first entry of the range, i.e. the entries of the previous components
+         * @param labels id of the component of each node, neighbours are rewritten with it
+         * @param next the contracted adjacency, with one row per component and room for all the kept entries
+         */
+        void gatherRows(uint begin, uint end, uint64_t position, const std::vector<uint> &members, const std::vector<uint64_t> &first,
+                        const std::vector<char> &flags, const std::vector<uint> &labels, CSRGraph &next) const {
+
+            for (uint component = begin; component < end; component++) {
+
+                next.offsets[component] = position;
+
+                for (uint64_t m = first[component]; m < first[component+1]; m++) {
+
+                    uint row = members[m];
+
+                    for (uint64_t i = offsets[row]; i < offsets[row+1]; i++) {
+                        if (flags[i]) {
+                            next.neighbours[position] = labels[neighbours[i]];
+                            next.weights[position] = weights[i];
+                            next.ids[position] = ids[i];
+                            position++;
+                        }
+                    }
+
+                }
+
+            }
+
+            if (end == next.numRows())
+                next.offsets[end] = position;
+
+        }
+
+    private:
+
+        /**
+         * @brief Compute the index of the first element of each row of a list sorted by row
+         *
+         * @param starts numNodes+1 entries, rows without elements start where the next row starts
+         */
+        template <typename ArrayT, typename RowF>
+        static void row_starts(const ArrayT &sorted, uint numNodes, uint nw, RowF row_of, std::vector<uint64_t> &starts) {
+
+            size_t m = sorted.size();
+
+            // Element i starts the rows from the one after the row of the previous edge up to its own
+            parallel_chunks(m, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+                    uint64_t first_row = i == 0 ? 0 : static_cast<uint64_t>(row_of(sorted[i-1])) + 1;
+                    for (uint64_t row = first_row; row <= row_of(sorted[i]); row++)
+                        starts[row] = i;
+                }
+            });
+
+            // Rows after the last element are empty
+            uint64_t last_row = m == 0 ? 0 : static_cast<uint64_t>(row_of(sorted[m-1])) + 1;
+
+            for (uint64_t row = last_row; row <= numNodes; row++)
+                starts[row] = m;
+
+        }
+
+};
+
+#endif
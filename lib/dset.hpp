@@ -83,15 +83,32 @@ class DisjointSets {
          * @return uint32_t 
          * 
          * Unite two different node under the same parent.
-         * Iterative loop that find the parent of both nodes, swap the rank of both nodes and return the new parent
+         * Same as merge, returning the parent of the united subtree
          */
         uint32_t unite(uint32_t id1, uint32_t id2) {
+            merge(id1, id2);
+            return find(id1);
+        }
+
+        /**
+         * @brief Unite the subtrees of two nodes, telling whether this call linked them
+         * 
+         * @param id1 first node
+         * @param id2 second node
+         * @return true if the call linked two different subtrees
+         * @return false if the nodes already were in the same subtree
+         * 
+         * Iterative loop that find the parent of both nodes and links the root of lower rank under the other one.
+         * When several threads unite the same two subtrees only one of them links them, so the calls returning
+         * true are exactly the edges of a spanning forest
+         */
+        bool merge(uint32_t id1, uint32_t id2) {
             for (;;) {
                 id1 = find(id1);
                 id2 = find(id2);
 
                 if (id1 == id2)
-                    return id1;
+                    return false;
 
                 uint32_t r1 = rank(id1), r2 = rank(id2);
 
@@ -113,9 +130,8 @@ class DisjointSets {
                     mData[id2].compare_exchange_weak(oldEntry, newEntry);
                 }
 
-                break;
+                return true;
             }
-            return id2;
         }
         
         // Return the size of the data structure
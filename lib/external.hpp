@@ -0,0 +1,411 @@
+#if !defined(__EXTERNAL_H)
+#define __EXTERNAL_H
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utils.hpp"
+#include "dset.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+#include "relabel.hpp"
+#include "snapshot.hpp"
+#include "utimer.hpp"
+#include "mst.hpp"
+
+/**
+ * @brief Sequence of edge records stored in a file
+ *
+ * Either an existing file (e.g. the edge table of a snapshot, starting at a given offset, of MyEdge records), or
+ * an anonymous temporary file used to spill the edges surviving a round (IdEdge records). Temporary files are
+ * unlinked as soon as they are created, so they disappear when closed.
+ */
+template <typename EdgeT>
+class EdgeFile {
+
+    public:
+
+        /**
+         * @brief Open count records of an existing file, starting at the given byte offset
+         */
+        EdgeFile(const std::string &filename, uint64_t offset, uint64_t count) : offset(offset), count(count) {
+            fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("cannot open " + filename);
+        }
+
+        /**
+         * @brief Create an empty temporary file in the given directory
+         */
+        EdgeFile(const std::string &directory) : offset(0), count(0) {
+            std::string path = directory + "/boruvka_spill_XXXXXX";
+            std::vector<char> name (path.begin(), path.end());
+            name.push_back('\0');
+            fd = mkstemp(name.data());
+            if (fd < 0)
+                throw std::runtime_error("cannot create a spill file in " + directory);
+            unlink(name.data());
+        }
+
+        ~EdgeFile() {
+            if (fd >= 0)
+                close(fd);
+        }
+
+        EdgeFile(EdgeFile const&) = delete;
+        EdgeFile& operator=(const EdgeFile&) = delete;
+
+        // Number of records in the file
+        uint64_t size() const { return count; }
+
+        /**
+         * @brief Read up to n records starting from record first
+         *
+         * @return size_t the number of records read
+         */
+        size_t read(uint64_t first, size_t n, EdgeT *out) const {
+
+            if (first >= count)
+                return 0;
+
+            n = std::min<uint64_t>(n, count - first);
+
+            char *buffer = reinterpret_cast<char *>(out);
+            size_t bytes = n * sizeof(EdgeT);
+            off_t position = offset + first * sizeof(EdgeT);
+
+            while (bytes > 0) {
+                ssize_t done = pread(fd, buffer, bytes, position);
+                if (done <= 0)
+                    throw std::runtime_error("cannot read edge file");
+                buffer += done;
+                bytes -= done;
+                position += done;
+            }
+
+            return n;
+
+        }
+
+        /**
+         * @brief Append n records at the end of the file
+         */
+        void append(const EdgeT *edges, size_t n) {
+
+            const char *buffer = reinterpret_cast<const char *>(edges);
+            size_t bytes = n * sizeof(EdgeT);
+            off_t position = offset + count * sizeof(EdgeT);
+
+            while (bytes > 0) {
+                ssize_t done = pwrite(fd, buffer, bytes, position);
+                if (done <= 0)
+                    throw std::runtime_error("cannot write edge file");
+                buffer += done;
+                bytes -= done;
+                position += done;
+            }
+
+            count += n;
+
+        }
+
+        // Drop all the records of a temporary file
+        void clear() {
+            if (ftruncate(fd, offset) != 0)
+                throw std::runtime_error("cannot truncate edge file");
+            count = 0;
+        }
+
+    private:
+
+        int fd = -1;
+
+        uint64_t offset;
+
+        uint64_t count;
+
+};
+
+
+/**
+ * @brief External memory Boruvka, for edge lists that do not fit in memory
+ *
+ * Only the per-node state (the minimum edge of each node and the union-find) lives in memory. Every round
+ * streams the current edge file chunk by chunk twice: once to find the minimum edges, as in mapwork/mergework,
+ * and once to filter the edges, as in filteringedgework, appending the survivors relabeled over the components
+ * left to a spill file that becomes the input of the next round. As soon as the survivors fit in the memory budget they are loaded into the
+ * graph and the caller continues with the in-memory engine.
+ */
+class ExternalBoruvka {
+
+    public:
+
+        /**
+         * @brief Construct a new external engine over the edges of a snapshot
+         *
+         * @param snapshot path of the graph snapshot
+         * @param memory memory budget for the edges, in bytes
+         * @param directory directory of the spill files
+         * @param nw number of workers
+         */
+        ExternalBoruvka(const std::string &snapshot, size_t memory, const std::string &directory, uint nw) :
+            snapshot(snapshot), memory(memory), directory(directory), nw(nw) {
+
+            Snapshot header(snapshot);
+
+            edgesOffset = header.edgesOffset();
+            numEdges = header.numEdges();
+
+            // A quarter of the budget for the chunk being read, as much for the edges selected from it (with their ids), less for the
+            // loaded records of a chunk of the first round, read before being given their ids
+            chunk = std::max<size_t>(memory / 4 / sizeof(IdEdge), 1024);
+
+        }
+
+        /**
+         * @brief Check whether the edges of the snapshot fit in the memory budget
+         */
+        bool fits() const {
+            return fits(numEdges);
+        }
+
+        /**
+         * @brief Run the external rounds
+         *
+         * @param components the union-find over all the nodes
+         * @param graph the working graph of the run, over the node table loaded with no edges
+         * @param time total time spent in the rounds, in usec
+         * @param mst receives the edges added to the spanning tree by the rounds
+         * @return int the number of rounds performed
+         *
+         * When the call returns the graph holds the surviving edges and nodes, relabeled after every round, and
+         * components is a fresh union-find over them. If a round adds no edge to the forest the edges left
+         * cannot be contracted: the call returns with no edges in the graph
+         */
+        int run(DisjointSets &components, GraphView &graph, long &time, MSTRecorder &mst) {
+
+            EdgeFile<MyEdge> input (snapshot, edgesOffset, numEdges);
+
+            EdgeFile<IdEdge> spill_a (directory);
+            EdgeFile<IdEdge> spill_b (directory);
+
+            // Edges of the round: the loaded ones as long as current is NULL, then the survivors spilled by the previous round
+            EdgeFile<IdEdge> *current = NULL;
+            EdgeFile<IdEdge> *next = &spill_a;
+
+            buffer.resize(chunk);
+            loaded.resize(chunk);
+            local_edges.resize(nw);
+            selected_edges.resize(nw);
+
+            auto edges_left = [&]() -> uint64_t {
+                return current != NULL ? current->size() : input.size();
+            };
+
+            // Read the chunk of the edges of the round starting from edge first into buffer, the loaded edges get their positions as ids
+            auto read = [&](uint64_t first) -> size_t {
+
+                if (current != NULL)
+                    return current->read(first, chunk, buffer.data());
+
+                size_t n = input.read(first, chunk, loaded.data());
+
+                parallel_chunks(n, nw, [&](size_t begin, size_t end, uint) {
+                    for (size_t i = begin; i < end; i++)
+                        buffer[i] = {loaded[i], static_cast<uint>(first + i)};
+                });
+
+                return n;
+
+            };
+
+            int rounds = 0;
+
+            time = 0;
+
+            // Edges added to the spanning forest by the last round
+            size_t merged = 0;
+
+            while (!fits(edges_left()) && edges_left() > 0 && graph.getNumNodes() != 1) {
+
+                long round_time;
+
+                {
+                    Utimer timer("External round", &round_time);
+
+                    // Minimum edge of each node, each edge is a candidate for both its endpoints
+                    for (auto &local : local_edges)
+                        local.assign(graph.originalNodes, {0, 0, MAX_WEIGHT});
+
+                    for (uint64_t first = 0; first < edges_left(); first += chunk) {
+
+                        size_t n = read(first);
+
+                        parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+                            std::vector<IdEdge> &local = local_edges[thid];
+                            for (size_t i = begin; i < end; i++) {
+                                offer_edge(local, buffer[i]);
+                            }
+                        });
+
+                    }
+
+                    global_edges.assign(graph.originalNodes, {0, 0, MAX_WEIGHT});
+
+                    parallel_chunks(graph.originalNodes, nw, [&](size_t begin, size_t end, uint) {
+                        for (auto &local : local_edges)
+                            for (size_t i = begin; i < end; i++)
+                                if (lighter(local[i], global_edges[i]))
+                                    global_edges[i] = local[i];
+                    });
+
+                    // Contraction
+                    MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
+
+                    parallel_chunks(graph.originalNodes, nw, [&](size_t begin, size_t end, uint thid) {
+                        for (size_t i = begin; i < end; i++) {
+                            IdEdge edge = global_edges[i];
+                            if (!(edge == NULL_CONN) && components.merge(edge.from, edge.to))
+                                mst.record(thid, edge.id);
+                        }
+                    });
+
+                    merged = mst.endRound();
+
+                    // Nothing to contract although edges are left (e.g. NaN weights, never picked): the next rounds would be the same,
+                    // the round ends here and the call returns below
+                    if (merged != 0) {
+
+                        // Filtering of the nodes: the components left are numbered densely (see relabel.hpp)
+                        relabeling.reset(graph.originalNodes, nw);
+
+                        parallel_chunks(graph.getNumNodes(), nw, [&](size_t begin, size_t end, uint thid) {
+                            relabeling.countRoots(components, graph.nodes(), begin, end, thid);
+                        });
+
+                        relabeling.prefixSum();
+
+                        parallel_chunks(graph.getNumNodes(), nw, [&](size_t begin, size_t end, uint thid) {
+                            relabeling.assignLabels(components, graph.nodes(), begin, end, thid);
+                        });
+
+                        parallel_chunks(graph.originalNodes, nw, [&](size_t begin, size_t end, uint) {
+                            relabeling.flatten(components, begin, end);
+                        });
+
+                        // Filtering of the edges into the spill file, over the new ids
+                        next->clear();
+
+                        for (uint64_t first = 0; first < edges_left(); first += chunk) {
+
+                            size_t n = read(first);
+
+                            // Short chunks only run worker 0: the buffers of the others must not keep the edges of the previous chunk
+                            for (auto &vect : selected_edges)
+                                vect.clear();
+
+                            parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+                                for (size_t i = begin; i < end; i++) {
+                                    IdEdge edge = buffer[i];
+                                    if (relabeling.relabel(edge))
+                                        selected_edges[thid].push_back(edge);
+                                }
+                            });
+
+                            for (auto &vect : selected_edges)
+                                next->append(vect.data(), vect.size());
+
+                        }
+
+                        // The next round works on the new ids
+                        graph.renumberNodes(relabeling.numLabels());
+
+                        components = DisjointSets(graph.originalNodes);
+
+                    }
+
+                }
+
+                time += round_time;
+
+                // The edges left do not fit in memory and cannot be contracted: none is handed to the in-memory engine
+                if (merged == 0) {
+                    graph.survivors(0);
+                    graph.useSurvivors();
+                    return rounds;
+                }
+
+                rounds++;
+
+                if (current == NULL) {
+                    current = &spill_a;
+                    next = &spill_b;
+                }
+                else {
+                    std::swap(current, next);
+                }
+
+            }
+
+            // The survivors fit in memory: hand them to the in-memory engine, their ids apart
+            uint64_t remaining = edges_left();
+
+            EdgeBuffer &remaining_edges = graph.survivors(remaining);
+            IdBuffer &remaining_ids = graph.survivorIds();
+
+            for (uint64_t first = 0; first < remaining; first += chunk) {
+
+                size_t n = read(first);
+
+                parallel_chunks(n, nw, [&](size_t begin, size_t end, uint) {
+                    for (size_t i = begin; i < end; i++) {
+                        remaining_edges[first + i] = buffer[i];
+                        remaining_ids[first + i] = buffer[i].id;
+                    }
+                });
+
+            }
+
+            graph.useSurvivors();
+
+            return rounds;
+
+        }
+
+    private:
+
+        std::string snapshot;
+
+        size_t memory;
+
+        std::string directory;
+
+        uint nw;
+
+        uint64_t edgesOffset;
+
+        uint64_t numEdges;
+
+        size_t chunk;
+
+        // Buffers of the rounds, kept by the engine for the rounds of its next runs
+        std::vector<IdEdge> buffer;
+        std::vector<MyEdge> loaded;
+        std::vector<std::vector<IdEdge>> local_edges;
+        std::vector<std::vector<IdEdge>> selected_edges;
+        std::vector<IdEdge> global_edges;
+
+        Relabeling relabeling;
+
+        bool fits(uint64_t edges) const {
+            // The in-memory engine needs room for the edges and their ids, and for their filtered copy
+            return 2 * edges * sizeof(IdEdge) <= memory;
+        }
+
+};
+
+#endif
@@ -0,0 +1,263 @@
+#if !defined(__FILTER_KRUSKAL_H)
+#define __FILTER_KRUSKAL_H
+
+#include <vector>
+#include <algorithm>
+#include "utils.hpp"
+#include "dset.hpp"
+#include "sort.hpp"
+#include "rng.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief Filter-Kruskal minimum spanning forest, an alternative to the Boruvka rounds
+ *
+ * From "The Filter-Kruskal Minimum Spanning Tree Algorithm" by Osipov, Sanders and Singler. The edges are
+ * split around a pivot weight: the light half is solved first, then the heavy half is filtered, dropping the
+ * edges whose endpoints the light half already connected, and solved in turn. Partitions below a size
+ * threshold are sorted and scanned as in Kruskal. On graphs with many more edges than nodes most of the heavy
+ * edges are filtered out without ever being sorted.
+ *
+ * The partitioning, the filtering and the sorting of the partitions run on nw workers; the Kruskal scans
+ * are sequential, on the lock-free DisjointSets.
+ */
+class FilterKruskal {
+
+    public:
+
+        // Partitions up to this number of edges are sorted instead of split
+        static const size_t BASE_EDGES = 1 << 18;
+
+        /**
+         * @brief Prepare a run on the node id range [0, numNodes)
+         *
+         * @param nw number of workers
+         */
+        FilterKruskal(uint numNodes, uint nw) : components(numNodes), numNodes(numNodes), nw(nw) {}
+
+        /**
+         * @brief Compute the minimum spanning forest of the given edges
+         *
+         * @param edges the edges with their ids, rearranged in place by the run; their buffer is kept for the caller
+         * @return size_t number of edges of the forest
+         */
+        size_t run(IdEdgeBuffer &edges) {
+
+            data = edges.data();
+
+            scratch.resize(edges.size());
+
+            solve(0, edges.size(), 0);
+
+            return added;
+
+        }
+
+        // Ids of the edges of the forest, in the order they were added
+        const std::vector<uint> &forestEdges() const { return forest; }
+
+        // Number of partitions sorted by the run
+        int sortedPartitions() const { return sorted; }
+
+    private:
+
+        DisjointSets components;
+
+        uint numNodes;
+
+        uint nw;
+
+        size_t added = 0;
+
+        std::vector<uint> forest;
+
+        int sorted = 0;
+
+        // Edges of the run: every partition is a range of them, split in place into its light and heavy ranges
+        IdEdge *data = nullptr;
+
+        // Target of the scatter passes, the range [begin, end) of a partition is scattered into the same range here
+        IdEdgeBuffer scratch;
+
+        bool complete() const { return added + 1 >= numNodes; }
+
+        void solve(size_t begin, size_t end, int depth) {
+
+            if (begin == end || complete())
+                return;
+
+            if (end - begin <= BASE_EDGES) {
+                kruskal(begin, end);
+                return;
+            }
+
+            size_t middle;
+
+            // No progress when all the weights are the same: sort them all
+            if (!partition(begin, end, depth, middle)) {
+                kruskal(begin, end);
+                return;
+            }
+
+            solve(begin, middle, depth + 1);
+
+            if (complete())
+                return;
+
+            end = compact(middle, end, [this](const IdEdge &edge) {
+                return !components.same(edge.from, edge.to);
+            });
+
+            solve(middle, end, depth + 1);
+
+        }
+
+        /**
+         * @brief Copy the range [begin, end) of the scratch buffer back into the edges
+         */
+        void copyBack(size_t begin, size_t end) {
+            parallel_chunks(end - begin, nw, [&](size_t first, size_t last, uint) {
+                std::copy(scratch.begin() + begin + first, scratch.begin() + begin + last, data + begin + first);
+            });
+        }
+
+        /**
+         * @brief Split the edges [begin, end) around a pivot weight: the light ones first, then the heavier ones
+         *
+         * The pivot is the median weight of a sample of the edges. Every worker counts the light edges of its
+         * chunk, then scatters the light and heavy ones into the scratch buffer, at the offsets given by the prefix
+         * sums of the counts, and the range is copied back. Both halves keep the order of the edges.
+         *
+         * @param middle set to the start of the heavy edges
+         * @return false if no edge is heavier than the pivot
+         */
+        bool partition(size_t begin, size_t end, int depth, size_t &middle) {
+
+            const size_t n = end - begin;
+
+            const IdEdge *edges = data + begin;
+
+            CounterRNG rng (depth, n);
+
+            std::vector<uint32_t> sample (1024);
+
+            for (size_t i = 0; i < sample.size(); i++)
+                sample[i] = weight_key(edges[rng.bounded(i, static_cast<uint>(std::min<size_t>(n, UINT32_MAX)))].weight);
+
+            std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+
+            uint32_t pivot = sample[sample.size() / 2];
+
+            std::vector<size_t> light_offsets (nw + 1, 0);
+
+            parallel_chunks(n, nw, [&](size_t first, size_t last, uint thid) {
+                size_t count = 0;
+                for (size_t i = first; i < last; i++)
+                    count += weight_key(edges[i].weight) <= pivot;
+                light_offsets[thid + 1] = count;
+            });
+
+            // Chunks of a single worker when there are fewer edges than workers
+            uint chunks = n < nw ? 1 : nw;
+
+            std::vector<size_t> heavy_offsets (nw + 1, 0);
+
+            for (uint w = 0; w < chunks; w++) {
+                size_t chunk_end = w == chunks - 1 ? n : (w + 1) * (n / chunks);
+                heavy_offsets[w + 1] = heavy_offsets[w] + (chunk_end - w * (n / chunks)) - light_offsets[w + 1];
+                light_offsets[w + 1] += light_offsets[w];
+            }
+
+            if (heavy_offsets[chunks] == 0)
+                return false;
+
+            IdEdge *light = scratch.data() + begin;
+
+            IdEdge *heavy = light + light_offsets[chunks];
+
+            parallel_chunks(n, nw, [&](size_t first, size_t last, uint thid) {
+                size_t l = light_offsets[thid];
+                size_t h = heavy_offsets[thid];
+                for (size_t i = first; i < last; i++) {
+                    if (weight_key(edges[i].weight) <= pivot)
+                        light[l++] = edges[i];
+                    else
+                        heavy[h++] = edges[i];
+                }
+            });
+
+            copyBack(begin, end);
+
+            middle = begin + light_offsets[chunks];
+
+            return true;
+
+        }
+
+        /**
+         * @brief Keep the edges [begin, end) satisfying keep, in order, at the start of the range
+         *
+         * @return size_t the end of the edges kept
+         */
+        template <typename KeepF>
+        size_t compact(size_t begin, size_t end, KeepF keep) {
+
+            const size_t n = end - begin;
+
+            const uint workers = n < 4096 ? 1 : nw;
+
+            std::vector<size_t> offsets (workers + 1, 0);
+
+            parallel_chunks(n, workers, [&](size_t first, size_t last, uint thid) {
+                size_t count = 0;
+                for (size_t i = begin + first; i < begin + last; i++)
+                    count += keep(data[i]);
+                offsets[thid + 1] = count;
+            });
+
+            for (uint w = 0; w < workers; w++)
+                offsets[w + 1] += offsets[w];
+
+            parallel_chunks(n, workers, [&](size_t first, size_t last, uint thid) {
+                size_t position = begin + offsets[thid];
+                for (size_t i = begin + first; i < begin + last; i++)
+                    if (keep(data[i]))
+                        scratch[position++] = data[i];
+            });
+
+            copyBack(begin, begin + offsets[workers]);
+
+            return begin + offsets[workers];
+
+        }
+
+        /**
+         * @brief Sort the edges [begin, end) by weight and add them in order, skipping the ones closing a cycle
+         *
+         * The partitions and the filter keep the edges in id order and the sort is stable, so ties go to the
+         * lowest id as in lighter()
+         */
+        void kruskal(size_t begin, size_t end) {
+
+            IdEdge *edges = data + begin;
+
+            const size_t n = end - begin;
+
+            if (parallel_radix_sort(edges, scratch.data() + begin, n, [](const IdEdge &edge) { return static_cast<uint64_t>(weight_key(edge.weight)); }, 32, nw))
+                copyBack(begin, end);
+
+            sorted++;
+
+            for (size_t i = 0; i < n && !complete(); i++) {
+                if (!components.same(edges[i].from, edges[i].to)) {
+                    components.unite(edges[i].from, edges[i].to);
+                    forest.push_back(edges[i].id);
+                    added++;
+                }
+            }
+
+        }
+
+};
+
+#endif
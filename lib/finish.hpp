@@ -0,0 +1,233 @@
+#if !defined(__FINISH_H)
+#define __FINISH_H
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include "utils.hpp"
+#include "sort.hpp"
+#include "rng.hpp"
+#include "minima.hpp"
+
+/**
+ * Sequential finish of the Boruvka rounds
+ *
+ * The late rounds only contract a few components, but still pay the dispatch to the workers, the arrays sized
+ * to the node id range and full passes over the edges left. Once the residual graph is small it is cheaper
+ * to finish it in cache:
+ * - with few edges left, a sequential Kruskal on them;
+ * - with few components left (but possibly many parallel edges between them), one pass keeping the lightest
+ *   edge between each pair of components in a dense matrix, then a sequential Prim on the matrix.
+ */
+
+// Largest number of components of the dense finish, whose matrix has the square of it entries
+const uint DENSE_FINISH_NODES = 1024;
+
+// Largest number of edges of the calibrated Kruskal finish: beyond it the edges leave the cache and the cost
+// measured by FinishCosts no longer holds
+const size_t KRUSKAL_FINISH_EDGES = 1 << 20;
+
+
+/**
+ * @brief Sequential Kruskal on the residual edges
+ *
+ * The edges are sorted by weight with a radix sort on a single worker, then added to the forest with a plain
+ * (not atomic) union-find with path halving, stopping as soon as the forest spans all the components.
+ *
+ * @param edges the residual edges with their ids, in id order, sorted in place (the sort is stable: ties go to the lowest id)
+ * @param numNodes size of the node id range
+ * @param record function called as record(edge) on every edge added to the spanning forest
+ * @return size_t number of edges added to the spanning forest
+ */
+template <typename RecordF>
+size_t kruskal(std::vector<IdEdge> &edges, uint numNodes, RecordF record) {
+
+    parallel_radix_sort(edges, [](const IdEdge &edge) { return static_cast<uint64_t>(weight_key(edge.weight)); }, 32, 1);
+
+    std::vector<uint> parent (numNodes);
+
+    for (uint node = 0; node < numNodes; node++)
+        parent[node] = node;
+
+    auto find = [&parent](uint node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+
+    size_t added = 0;
+
+    for (size_t i = 0; i < edges.size() && added + 1 < numNodes; i++) {
+
+        uint a = find(edges[i].from);
+        uint b = find(edges[i].to);
+
+        if (a != b) {
+            parent[std::max(a, b)] = std::min(a, b);
+            record(edges[i]);
+            added++;
+        }
+
+    }
+
+    return added;
+
+}
+
+
+/**
+ * @brief Keep the lightest of the edges [begin, end) between each pair of components
+ *
+ * @param edges the residual edges in id order, so that ties go to the lowest id
+ * @param matrix k * k packed edges (see PackedMinima::pack), the edge between a > b goes to entry a * k + b;
+ *        entries without any edge must be PackedMinima::EMPTY
+ */
+inline void dense_minima(const std::vector<IdEdge> &edges, size_t begin, size_t end, uint k, std::vector<uint64_t> &matrix) {
+
+    for (size_t i = begin; i < end; i++) {
+
+        uint64_t packed = PackedMinima::pack(edges[i].weight, static_cast<uint>(i));
+
+        uint64_t &entry = matrix[static_cast<size_t>(edges[i].from) * k + edges[i].to];
+
+        if (packed < entry)
+            entry = packed;
+
+    }
+
+}
+
+
+/**
+ * @brief Sequential Prim on the dense matrix of dense_minima, in O(k^2)
+ *
+ * Every component left out of the tree grown so far starts a new tree, so the result is a spanning forest
+ *
+ * @param record function called as record(index) with the index in the edges of dense_minima of every edge
+ *        added to the spanning forest
+ * @return size_t number of edges added to the spanning forest
+ */
+template <typename RecordF>
+size_t dense_prim(const std::vector<uint64_t> &matrix, uint k, RecordF record) {
+
+    // Lightest packed edge from each component out of the tree to the tree
+    std::vector<uint64_t> distance (k, PackedMinima::EMPTY);
+
+    std::vector<char> in_tree (k, 0);
+
+    size_t added = 0;
+
+    for (uint step = 0; step < k; step++) {
+
+        // Closest component out of the tree, or the first one left to start a new tree
+        uint next = k;
+
+        for (uint v = 0; v < k; v++)
+            if (!in_tree[v] && (next == k || distance[v] < distance[next]))
+                next = v;
+
+        if (distance[next] != PackedMinima::EMPTY) {
+            record(static_cast<uint>(distance[next]));
+            added++;
+        }
+
+        in_tree[next] = 1;
+
+        for (uint v = 0; v < k; v++) {
+            uint64_t entry = matrix[static_cast<size_t>(std::max(next, v)) * k + std::min(next, v)];
+            if (!in_tree[v] && entry < distance[v])
+                distance[v] = entry;
+        }
+
+    }
+
+    return added;
+
+}
+
+
+/**
+ * @brief Measured costs of the two finishes, to tell when they are cheaper than another round
+ */
+struct FinishCosts {
+
+    // Microseconds of Kruskal per edge and per bit of the number of edges (modeled as c * m * log2(m))
+    double kruskal_us = 0;
+
+    // Microseconds of the dense pass per edge
+    double dense_us = 0;
+
+    // Microseconds per edge to gather the residual edges into a list, paid by both finishes
+    double copy_us = 0;
+
+    /**
+     * @brief Run both finishes on a random graph of m edges, over a quarter as many nodes for Kruskal and
+     *        DENSE_FINISH_NODES for the dense pass
+     */
+    static FinishCosts calibrate(size_t m = 1 << 18) {
+
+        CounterRNG rng (1);
+
+        std::vector<IdEdge> edges (m);
+
+        auto random_edges = [&](uint n) {
+            for (size_t i = 0; i < m; i++) {
+                uint a = rng.bounded(3 * i, n);
+                uint b = rng.bounded(3 * i + 1, n);
+                edges[i] = {std::max(a, b), std::min(a, b), static_cast<float>(1.0 + 9.0 * rng.uniform(3 * i + 2)), static_cast<uint>(i)};
+            }
+        };
+
+        FinishCosts costs;
+
+        random_edges(static_cast<uint>(m / 4));
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<IdEdge> copy (edges);
+
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        costs.copy_us = elapsed.count() / m;
+
+        start = std::chrono::steady_clock::now();
+
+        kruskal(edges, static_cast<uint>(m / 4), [](const IdEdge &) {});
+
+        elapsed = std::chrono::steady_clock::now() - start;
+
+        costs.kruskal_us = elapsed.count() / (m * std::log2(static_cast<double>(m)));
+
+        random_edges(DENSE_FINISH_NODES);
+
+        std::vector<uint64_t> matrix (static_cast<size_t>(DENSE_FINISH_NODES) * DENSE_FINISH_NODES, PackedMinima::EMPTY);
+
+        start = std::chrono::steady_clock::now();
+
+        dense_minima(edges, 0, m, DENSE_FINISH_NODES, matrix);
+
+        elapsed = std::chrono::steady_clock::now() - start;
+
+        costs.dense_us = elapsed.count() / m;
+
+        return costs;
+
+    }
+
+    // Estimated time of Kruskal on m edges, in microseconds
+    double kruskalTime(size_t m) const {
+        return m < 2 ? 0 : copy_us * m + kruskal_us * m * std::log2(static_cast<double>(m));
+    }
+
+    // Estimated time of the dense finish on m edges split among nw workers and k components, in microseconds (the
+    // merge of the matrices and Prim are counted as two more passes over the k * k entries)
+    double denseTime(size_t m, uint k, uint nw) const {
+        return copy_us * m + dense_us * (static_cast<double>(m) / nw + 2.0 * k * k);
+    }
+
+};
+
+#endif
@@ -0,0 +1,428 @@
+#if !defined(__FORMATS_H)
+#define __FORMATS_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <functional>
+#include <atomic>
+#include "utils.hpp"
+#include "parallel.hpp"
+#include "parser.hpp"
+
+/**
+ * Registry of the input graph formats
+ *
+ * Every format has a name (used by the format=name option), the file extensions it is usually stored with,
+ * an optional check of the first bytes of the file, a check of whether the file carries edge weights and a
+ * parser. Parsers work on the memory mapped file, split at line boundaries among the workers, and hand each
+ * block of parsed edges to a sink as soon as it is ready, with 0-based node ids. Edges of unweighted files
+ * have weight 0.
+ */
+namespace formats {
+
+    /**
+     * @brief Consumer of the parsed edges, called as sink(index, edges) by worker index on each block
+     *
+     * Blocks are handed in file order within a worker, the vector may be modified.
+     */
+    typedef std::function<void(uint, std::vector<MyEdge> &)> EdgeSink;
+
+    typedef bool (*DetectF)(const char *data, size_t size);
+
+    typedef void (*ParseF)(const char *data, size_t size, uint nw, const EdgeSink &sink);
+
+    struct Format {
+        const char *name;
+        std::vector<std::string> extensions;
+        DetectF detect;
+        DetectF weighted;
+        ParseF parse;
+    };
+
+
+    /**
+     * @brief Return the first line of [p, end) that is not empty and does not start with the comment character
+     */
+    inline const char *first_line(const char *p, const char *end, char comment) {
+        while (p < end) {
+            const char *q = parser::skip_blanks(p, end);
+            if (q < end && *q != '\n' && *q != comment)
+                return p;
+            p = parser::next_line(p, end);
+        }
+        return end;
+    }
+
+    /**
+     * @brief Return the first line of [p, end) starting with a number
+     */
+    inline const char *first_data_line(const char *p, const char *end) {
+        while (p < end) {
+            const char *q = parser::skip_blanks(p, end);
+            if (q < end && parser::is_digit(*q))
+                return p;
+            p = parser::next_line(p, end);
+        }
+        return end;
+    }
+
+    /**
+     * @brief Count the numbers at the beginning of the line starting at p
+     */
+    inline int count_columns(const char *p, const char *end) {
+        const char *line_end = parser::next_line(p, end);
+        int columns = 0;
+        float value;
+        while (parser::parse_float(p, line_end, value))
+            columns++;
+        return columns;
+    }
+
+    /**
+     * @brief Sink of a format with 1-based ids, shifting each block to 0-based before handing it over
+     *
+     * Blocks with a node id 0, which the format does not allow, are not handed over but flagged in zero_id:
+     * the parse function throws once the parser threads are done, see check_one_based()
+     */
+    inline EdgeSink one_based(const EdgeSink &sink, std::atomic<bool> &zero_id) {
+
+        return [&sink, &zero_id](uint index, std::vector<MyEdge> &edges) {
+
+            for (auto &edge : edges)
+                if (edge.from == 0 || edge.to == 0) {
+                    zero_id = true;
+                    return;
+                }
+
+            for (auto &edge : edges) {
+                edge.from--;
+                edge.to--;
+            }
+
+            sink(index, edges);
+
+        };
+
+    }
+
+    inline void check_one_based(const std::atomic<bool> &zero_id, const char *format) {
+
+        if (zero_id)
+            throw std::runtime_error(std::string("node id 0 in a ") + format + " file, whose ids start from 1");
+
+    }
+
+    /**
+     * @brief Whitespace separated "from to [weight]" lines with the given id base
+     *
+     * The file is weighted if its first data line has at least three columns. Lines that do not start with a
+     * number are skipped, so '#' and '%' comments need no special handling.
+     */
+    inline bool edge_list_weighted(const char *data, size_t size) {
+        return count_columns(first_data_line(data, data + size), data + size) >= 3;
+    }
+
+    inline void parse_edge_list(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+        parser::stream_edges(data, size, edge_list_weighted(data, size), nw, sink);
+
+    }
+
+    // Plain edge list, 0-based
+    inline void parse_plain(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+        parse_edge_list(data, size, nw, sink);
+    }
+
+    // Network Repository .edges files (e.g. sc-rel9, soc-youtube), 1-based: 0-based ones are read with format=edgelist
+    inline void parse_netrepo(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+
+        std::atomic<bool> zero_id {false};
+
+        parse_edge_list(data, size, nw, one_based(sink, zero_id));
+
+        check_one_based(zero_id, "Network Repository .edges");
+
+    }
+
+    // SNAP edge lists start with '#' comments
+    inline bool detect_snap(const char *data, size_t size) {
+        return size > 0 && data[0] == '#';
+    }
+
+
+    /**
+     * @brief Matrix Market coordinate files
+     *
+     * "%%MatrixMarket matrix coordinate <field> <symmetry>" header, '%' comments, a "rows cols entries" line,
+     * then one "i j [value]" entry per line with 1-based indexes. Pattern matrices are unweighted. Symmetric
+     * matrices only list one triangle, which is fine since the graph is made undirected anyway.
+     */
+    inline bool detect_matrix_market(const char *data, size_t size) {
+        return size >= 14 && memcmp(data, "%%MatrixMarket", 14) == 0;
+    }
+
+    // Lower case banner line of a Matrix Market file
+    inline std::string matrix_market_banner(const char *data, size_t size) {
+
+        std::string banner (data, parser::next_line(data, data + size));
+
+        for (auto &c : banner)
+            c = tolower(c);
+
+        return banner;
+
+    }
+
+    inline bool matrix_market_weighted(const char *data, size_t size) {
+        return matrix_market_banner(data, size).find("pattern") == std::string::npos;
+    }
+
+    inline void parse_matrix_market(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+
+        const char *end = data + size;
+
+        if (matrix_market_banner(data, size).find("coordinate") == std::string::npos)
+            throw std::runtime_error("only coordinate Matrix Market files are supported");
+
+        // Entries start after the size line
+        const char *body = parser::next_line(first_line(parser::next_line(data, end), end, '%'), end);
+
+        std::atomic<bool> zero_id {false};
+
+        parser::stream_edges(body, end - body, matrix_market_weighted(data, size), nw, one_based(sink, zero_id));
+
+        check_one_based(zero_id, "Matrix Market");
+
+    }
+
+
+    /**
+     * @brief DIMACS shortest path files (.gr)
+     *
+     * 'c' comment lines, a "p sp nodes arcs" problem line and "a u v w" arc lines with 1-based ids
+     */
+    inline bool detect_dimacs(const char *data, size_t size) {
+        const char *p = first_line(data, data + size, '%');
+        return p + 1 < data + size && (*p == 'c' || *p == 'p') && (parser::is_blank(p[1]) || p[1] == '\n');
+    }
+
+    inline bool dimacs_weighted(const char *, size_t) {
+        return true;
+    }
+
+    inline void parse_dimacs(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+
+        std::atomic<bool> zero_id {false};
+
+        parser::stream_chunks(data, size, nw, [](const char *begin, const char *end, std::vector<MyEdge> &out) {
+
+            const char *p = begin;
+
+            while (p < end) {
+
+                const char *line_end = parser::next_line(p, end);
+
+                uint a, b;
+                float c;
+
+                const char *q = p + 1;
+
+                if (*p == 'a' && parser::parse_uint(q, line_end, a) && parser::parse_uint(q, line_end, b) && parser::parse_float(q, line_end, c))
+                    out.push_back({a, b, c});
+
+                p = line_end;
+
+            }
+
+        }, one_based(sink, zero_id));
+
+        check_one_based(zero_id, "DIMACS");
+
+    }
+
+
+    /**
+     * @brief METIS graph files (.graph)
+     *
+     * A "nodes edges [fmt [ncon]]" header, then line i lists the neighbours of node i (1-based), '%' lines are
+     * comments. The digits of fmt tell whether each line starts with the node size (hundreds), with ncon node
+     * weights (tens), and whether each neighbour is followed by the edge weight (units).
+     *
+     * Since the source node is given by the line number, the lines of each chunk are counted first, and a
+     * prefix sum gives the first node of each chunk.
+     */
+    struct MetisHeader {
+        const char *body;
+        uint fmt;
+        uint ncon;
+    };
+
+    inline MetisHeader metis_header(const char *data, size_t size) {
+
+        const char *end = data + size;
+        const char *header = first_line(data, end, '%');
+        const char *header_end = parser::next_line(header, end);
+
+        uint nodes = 0, edges = 0;
+        MetisHeader result = {header_end, 0, 1};
+
+        const char *q = header;
+
+        if (!parser::parse_uint(q, header_end, nodes) || !parser::parse_uint(q, header_end, edges))
+            throw std::runtime_error("malformed METIS header");
+
+        if (parser::parse_uint(q, header_end, result.fmt))
+            parser::parse_uint(q, header_end, result.ncon);
+
+        return result;
+
+    }
+
+    inline bool metis_weighted(const char *data, size_t size) {
+        return metis_header(data, size).fmt % 10 == 1;
+    }
+
+    inline void parse_metis(const char *data, size_t size, uint nw, const EdgeSink &sink) {
+
+        MetisHeader header = metis_header(data, size);
+
+        bool has_size = (header.fmt / 100) % 10 == 1;
+        bool has_node_weights = (header.fmt / 10) % 10 == 1;
+        bool weighted = header.fmt % 10 == 1;
+
+        const char *body = header.body;
+        size_t body_size = data + size - body;
+
+        std::vector<size_t> bounds = parser::split_lines(body, body_size, nw);
+
+        // Node lines of each chunk
+        std::vector<uint> first_node (nw + 1, 0);
+
+        parallel_chunks(nw, nw, [&](size_t begin, size_t stop, uint) {
+            for (size_t i = begin; i < stop; i++) {
+                uint lines = 0;
+                for (const char *p = body + bounds[i]; p < body + bounds[i+1]; p = parser::next_line(p, body + bounds[i+1]))
+                    if (*p != '%')
+                        lines++;
+                first_node[i+1] = lines;
+            }
+        });
+
+        for (uint i = 0; i < nw; i++)
+            first_node[i+1] += first_node[i];
+
+        // Set by the chunks listing a neighbour 0, which METIS ids do not allow
+        std::atomic<bool> zero_id {false};
+
+        parallel_chunks(nw, nw, [&](size_t begin, size_t stop, uint) {
+
+            std::vector<MyEdge> edges;
+
+            for (size_t i = begin; i < stop; i++) {
+
+                uint node = first_node[i];
+                const char *chunk_end = body + bounds[i+1];
+
+                for (const char *p = body + bounds[i]; p < chunk_end; ) {
+
+                    const char *line_end = parser::next_line(p, chunk_end);
+
+                    if (*p == '%') {
+                        p = line_end;
+                        continue;
+                    }
+
+                    float skipped;
+
+                    if (has_size)
+                        parser::parse_float(p, line_end, skipped);
+
+                    if (has_node_weights)
+                        for (uint k = 0; k < header.ncon; k++)
+                            parser::parse_float(p, line_end, skipped);
+
+                    uint neighbour;
+
+                    while (parser::parse_uint(p, line_end, neighbour)) {
+                        float weight = 0;
+                        if (weighted && !parser::parse_float(p, line_end, weight))
+                            break;
+                        if (neighbour == 0)
+                            zero_id = true;
+                        else
+                            edges.push_back({node, neighbour - 1, weight});
+                    }
+
+                    node++;
+                    p = line_end;
+
+                    // Hand over blocks of about the same size as the line based parsers
+                    if (edges.size() * sizeof(MyEdge) >= parser::PARSE_BLOCK_BYTES || p >= chunk_end) {
+                        sink(i, edges);
+                        edges.clear();
+                    }
+
+                }
+
+            }
+
+        });
+
+        check_one_based(zero_id, "METIS");
+
+    }
+
+
+    /**
+     * @brief The registered formats
+     */
+    inline const std::vector<Format> &registry() {
+
+        static const std::vector<Format> formats = {
+            { "mm",       { ".mtx" },              detect_matrix_market, matrix_market_weighted, parse_matrix_market },
+            { "dimacs",   { ".gr" },               detect_dimacs,        dimacs_weighted,        parse_dimacs },
+            { "snap",     { },                     detect_snap,          edge_list_weighted,     parse_plain },
+            { "metis",    { ".graph", ".metis" },  NULL,                 metis_weighted,         parse_metis },
+            { "edges",    { ".edges" },            NULL,                 edge_list_weighted,     parse_netrepo },
+            { "edgelist", { },                     NULL,                 edge_list_weighted,     parse_plain },
+        };
+
+        return formats;
+
+    }
+
+    /**
+     * @brief Look up a format by name
+     */
+    inline const Format &find(const std::string &name) {
+
+        for (auto &format : registry())
+            if (name == format.name)
+                return format;
+
+        throw std::runtime_error("unknown graph format " + name);
+
+    }
+
+    /**
+     * @brief Pick the format of a file: by its first bytes, then by its extension, plain edge list otherwise
+     */
+    inline const Format &detect(const std::string &filename, const char *data, size_t size) {
+
+        for (auto &format : registry())
+            if (format.detect != NULL && format.detect(data, size))
+                return format;
+
+        for (auto &format : registry())
+            for (auto &extension : format.extensions)
+                if (filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0)
+                    return format;
+
+        return find("edgelist");
+
+    }
+
+}
+
+#endif
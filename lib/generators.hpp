@@ -0,0 +1,298 @@
+#if !defined(__GENERATORS_H)
+#define __GENERATORS_H
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "utils.hpp"
+#include "rng.hpp"
+#include "parallel.hpp"
+#include "sort.hpp"
+
+/**
+ * Synthetic workload generators
+ *
+ * Every generator returns undirected edges (from > to) as a flat list that may still contain duplicates and
+ * self loops, the Graph takes care of dropping them and of storing both directions. All the random choices
+ * are taken from counter based streams indexed by the edge number, so the output only depends on the
+ * parameters and on the seed, not on the number of workers.
+ */
+
+/**
+ * @brief Distribution of the edge weights
+ *
+ * - UNIFORM: uniform in [1, 10)
+ * - EXPONENTIAL: 1 plus an exponential with mean 1, few heavy edges
+ * - NORMAL: normal with mean 5.5 and standard deviation 1.5, clamped to [1, 10)
+ * - INTEGER: uniform integer in [1, 10], lots of ties
+ */
+enum class WeightDistribution { UNIFORM, EXPONENTIAL, NORMAL, INTEGER };
+
+
+/**
+ * @brief Parse the name of a weight distribution (uniform, exp, normal, int)
+ */
+inline WeightDistribution parse_weights(const std::string &name) {
+    if (name.empty() || name == "uniform") return WeightDistribution::UNIFORM;
+    if (name == "exp") return WeightDistribution::EXPONENTIAL;
+    if (name == "normal") return WeightDistribution::NORMAL;
+    if (name == "int") return WeightDistribution::INTEGER;
+    throw std::runtime_error("unknown weight distribution " + name);
+}
+
+
+/**
+ * @brief Draw the weight of edge k from the given stream
+ */
+inline float draw_weight(WeightDistribution weights, const CounterRNG &stream, uint64_t k) {
+
+    const int MIN = 1;
+    const int MAX = 10;
+
+    switch (weights) {
+
+        case WeightDistribution::EXPONENTIAL:
+            return MIN - std::log(1.0 - stream.uniform(k));
+
+        case WeightDistribution::NORMAL: {
+            // Box-Muller transform on two positions of the stream
+            double u1 = 1.0 - stream.uniform(2 * k);
+            double u2 = stream.uniform(2 * k + 1);
+            double z = std::sqrt(-2.0 * std::log(u1)) * std::cos(2 * M_PI * u2);
+            return std::min(std::max(5.5 + 1.5 * z, static_cast<double>(MIN)), std::nextafter(static_cast<double>(MAX), 0.0));
+        }
+
+        case WeightDistribution::INTEGER:
+            return MIN + stream.bounded(k, MAX - MIN + 1);
+
+        default:
+            return MIN + (MAX - MIN) * stream.uniform(k);
+
+    }
+
+}
+
+
+/**
+ * @brief Kind of graph produced by a generator
+ *
+ * - UNIFORM: uniform random graph (Graph::generateGraph)
+ * - RMAT: recursive matrix (Kronecker) graph with skewed, power-law degrees
+ * - GRID2D, GRID3D: 2D and 3D meshes, road network like
+ * - TORUS2D, TORUS3D: meshes with wrap-around edges
+ * - BA: Barabasi-Albert preferential attachment graph
+ */
+enum class GeneratorKind { UNIFORM, RMAT, GRID2D, GRID3D, TORUS2D, TORUS3D, BA };
+
+
+/**
+ * @brief Generator requested on the command line as "gen:<kind>[:<weights>]", e.g. "gen:rmat:exp"
+ */
+struct GeneratorSpec {
+    GeneratorKind kind;
+    WeightDistribution weights;
+};
+
+
+/**
+ * @brief Check whether the given filename argument is a generator specification
+ */
+inline bool is_generator(const std::string &spec) {
+    return spec.compare(0, 4, "gen:") == 0;
+}
+
+
+/**
+ * @brief Parse a generator specification
+ */
+inline GeneratorSpec parse_generator(const std::string &spec) {
+
+    std::string body = spec.substr(4);
+    size_t colon = body.find(':');
+
+    std::string kind = body.substr(0, colon);
+    std::string weights = colon == std::string::npos ? "" : body.substr(colon + 1);
+
+    GeneratorSpec result;
+    result.weights = parse_weights(weights);
+
+    if (kind == "uniform") result.kind = GeneratorKind::UNIFORM;
+    else if (kind == "rmat") result.kind = GeneratorKind::RMAT;
+    else if (kind == "grid2d") result.kind = GeneratorKind::GRID2D;
+    else if (kind == "grid3d") result.kind = GeneratorKind::GRID3D;
+    else if (kind == "torus2d") result.kind = GeneratorKind::TORUS2D;
+    else if (kind == "torus3d") result.kind = GeneratorKind::TORUS3D;
+    else if (kind == "ba") result.kind = GeneratorKind::BA;
+    else throw std::runtime_error("unknown generator " + kind);
+
+    return result;
+
+}
+
+
+/**
+ * @brief Generate the edges of a R-MAT graph
+ *
+ * @param scale the graph has 2^scale nodes
+ * @param m number of edges to draw
+ * @param a, b, c probabilities of the top-left, top-right and bottom-left quadrants (d = 1 - a - b - c)
+ * @param weights distribution of the weights
+ * @param seed seed of the streams
+ * @param nw number of workers
+ * @return std::vector<MyEdge> the undirected edges, duplicates and self loops included
+ *
+ * Edge k descends the adjacency matrix one level at a time choosing a quadrant with the given probabilities,
+ * using position k * scale + level of the quadrant stream. Default probabilities are the Graph500 ones.
+ */
+inline std::vector<MyEdge> rmat_edges(uint scale, size_t m, double a, double b, double c, WeightDistribution weights, uint64_t seed, uint nw) {
+
+    const CounterRNG quadrant_stream (seed, 10);
+    const CounterRNG weight_stream (seed, 11);
+
+    std::vector<MyEdge> edges (m);
+
+    parallel_chunks(m, nw, [&](size_t begin, size_t end, uint) {
+        for (size_t k = begin; k < end; k++) {
+
+            uint x = 0, y = 0;
+
+            for (uint level = 0; level < scale; level++) {
+                double r = quadrant_stream.uniform(k * scale + level);
+                uint bit = 1u << (scale - 1 - level);
+                if (r < a) {
+                    // top-left quadrant
+                }
+                else if (r < a + b) {
+                    y |= bit;
+                }
+                else if (r < a + b + c) {
+                    x |= bit;
+                }
+                else {
+                    x |= bit;
+                    y |= bit;
+                }
+            }
+
+            edges[k] = {std::max(x, y), std::min(x, y), draw_weight(weights, weight_stream, k)};
+
+        }
+    });
+
+    return edges;
+
+}
+
+
+/**
+ * @brief Generate the edges of a 2D or 3D grid
+ *
+ * @param dims the side of the grid along each dimension (2 or 3 values)
+ * @param torus whether the last node along each dimension is linked to the first one
+ * @param weights distribution of the weights
+ * @param seed seed of the weight stream
+ * @param nw number of workers
+ * @return std::vector<MyEdge> the undirected edges
+ *
+ * Node (x, y, z) has id x + X * (y + Y * z) and is linked to its successor along each dimension.
+ */
+inline std::vector<MyEdge> grid_edges(const std::vector<uint> &dims, bool torus, WeightDistribution weights, uint64_t seed, uint nw) {
+
+    const CounterRNG weight_stream (seed, 20);
+
+    const uint D = dims.size();
+
+    uint64_t n = 1;
+    for (uint side : dims)
+        n *= side;
+
+    // Slot d of node v holds the edge towards the successor along dimension d, if any
+    std::vector<MyEdge> edges (n * D);
+    std::vector<char> present (n * D, 0);
+
+    parallel_chunks(n, nw, [&](size_t begin, size_t end, uint) {
+        for (size_t v = begin; v < end; v++) {
+
+            uint64_t stride = 1;
+            uint64_t rest = v;
+
+            for (uint d = 0; d < D; d++) {
+
+                uint coordinate = rest % dims[d];
+                rest /= dims[d];
+
+                uint64_t k = v * D + d;
+
+                if (coordinate + 1 < dims[d]) {
+                    edges[k] = {static_cast<uint>(v + stride), static_cast<uint>(v), draw_weight(weights, weight_stream, k)};
+                    present[k] = 1;
+                }
+                else if (torus && dims[d] > 2) {
+                    uint64_t first = v - coordinate * stride;
+                    edges[k] = {static_cast<uint>(v), static_cast<uint>(first), draw_weight(weights, weight_stream, k)};
+                    present[k] = 1;
+                }
+
+                stride *= dims[d];
+
+            }
+
+        }
+    });
+
+    parallel_compact(edges, [&present](size_t k) { return present[k] != 0; }, nw);
+
+    return edges;
+
+}
+
+
+/**
+ * @brief Generate the edges of a Barabasi-Albert graph
+ *
+ * @param n number of nodes
+ * @param m number of edges added by each node
+ * @param weights distribution of the weights
+ * @param seed seed of the streams
+ * @param nw number of workers
+ * @return std::vector<MyEdge> the undirected edges, duplicates and self loops included
+ *
+ * Uses the edge list formulation of Batagelj and Brandes: position 2k of a virtual array holds the source
+ * node of edge k and position 2k+1 a copy of a uniformly chosen earlier position, which picks a target with
+ * probability proportional to its degree. As in the parallel generator of Sanders and Schulz the copies are
+ * resolved by following the chain of positions, so every edge can be computed independently.
+ */
+inline std::vector<MyEdge> barabasi_albert_edges(uint n, uint m, WeightDistribution weights, uint64_t seed, uint nw) {
+
+    const CounterRNG position_stream (seed, 30);
+    const CounterRNG weight_stream (seed, 31);
+
+    uint64_t total = static_cast<uint64_t>(n) * m;
+
+    std::vector<MyEdge> edges (total);
+
+    parallel_chunks(total, nw, [&](size_t begin, size_t end, uint) {
+        for (size_t k = begin; k < end; k++) {
+
+            uint source = k / m;
+
+            // Resolve position 2k+1: jump back until a source position (even) is reached
+            uint64_t position = 2 * k + 1;
+            while (position % 2 == 1)
+                position = static_cast<uint64_t>(position_stream.uniform(position) * position);
+
+            uint target = (position / 2) / m;
+
+            edges[k] = {std::max(source, target), std::min(source, target), draw_weight(weights, weight_stream, k)};
+
+        }
+    });
+
+    return edges;
+
+}
+
+#endif
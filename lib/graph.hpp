@@ -5,11 +5,20 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
-#include <set>
+#include <algorithm>
+#include <memory>
+#include <numeric>
 #include <unordered_map>
 #include <random>
 #include "utils.hpp"
-#include <vector>
+#include "dset.hpp"
+#include "mapped_file.hpp"
+#include "parser.hpp"
+#include "formats.hpp"
+#include "snapshot.hpp"
+#include "sort.hpp"
+#include "rng.hpp"
+#include "generators.hpp"
 
 class Graph {
 
@@ -18,10 +27,10 @@ class Graph {
         // Vector of nodes
         std::vector<uint> nodes;
 
-        // List of edges
+        // List of edges, each undirected edge stored once with from > to, sorted by (from, to)
         std::vector<MyEdge> edges; 
 
-        uint originalNodes;
+        uint originalNodes = 0;
 
         Graph() {}
 
@@ -34,157 +43,394 @@ class Graph {
             this->nodes = sample.nodes;
             this->edges = sample.edges;
             this->originalNodes = sample.originalNodes;
+            this->snapshot = sample.snapshot;
+            this->mappedNodes = sample.mappedNodes;
+            this->mappedEdges = sample.mappedEdges;
         }
 
 
-        std::vector<uint> getNodes() {
+        /**
+         * @brief Nodes of the graph: the vector above, or the node table of the snapshot it was loaded from
+         */
+        ArrayRef<uint> getNodes() const {
+            if (mappedNodes)
+                return ArrayRef<uint>(snapshot->nodes(), snapshot->numNodes());
             return this->nodes;
         }
 
-        uint getNumNodes() {
-            return this->nodes.size();
+        uint getNumNodes() const {
+            return this->getNodes().size();
         }
 
-        uint getNumEdges() {
-            return this->edges.size();
+        uint getNumEdges() const {
+            return this->getEdges().size();
         }
 
-        std::vector<MyEdge> getEdges() {
+        /**
+         * @brief Edges of the graph: the vector above, or the edge table of the snapshot it was loaded from
+         */
+        ArrayRef<MyEdge> getEdges() const {
+            if (mappedEdges)
+                return ArrayRef<MyEdge>(snapshot->edges(), snapshot->numEdges());
             return this->edges;
         }
 
+        /**
+         * @brief Release the edges once they have been converted to another layout, the nodes are kept
+         */
+        void dropEdges() {
+            std::vector<MyEdge>().swap(this->edges);
+            mappedEdges = false;
+            release();
+        }
+
         void updateNodes(std::vector<uint>& newNodes) {
             this->nodes.clear();
             this->nodes = newNodes;
+            mappedNodes = false;
+            release();
         }
 
         void updateEdges(std::vector<MyEdge>& newEdges) {
             this->edges.clear();
             this->edges = newEdges;
+            mappedEdges = false;
+            release();
         }
 
         /**
-         * @brief Load graph from textfile, by filling the vector of Edges above
-         */ 
-        void loadGraph(std::string filename) {
+         * @brief Replace the nodes with the dense ids 0 to n-1, after the edges have been relabeled (see relabel.hpp)
+         */
+        void renumberNodes(uint n) {
+            this->nodes.resize(n);
+            std::iota(this->nodes.begin(), this->nodes.end(), 0);
+            this->originalNodes = n;
+            mappedNodes = false;
+            release();
+        }
 
-            std::ifstream infile(filename);
+        /**
+         * @brief Build the node and edge vectors from a flat list of undirected edges
+         * 
+         * @param undirected list of edges, in any orientation, each one listed once. It is consumed by the call.
+         * 
+         * Every edge is stored once, in its canonical orientation from > to. Self loops are dropped, edges are
+         * sorted by (from, to) with a parallel radix sort and duplicates are dropped keeping the lightest copy.
+         * The id of every edge is its position in the sorted list. The nodes are the distinct endpoints of the edges.
+         */
+        void buildFrom(std::vector<MyEdge>& undirected) {
 
-            const int MIN = -1;
-            const int MAX = 1;
+            uint nw = default_workers();
 
-            uint a, b;
-            float c;
+            parallel_chunks(undirected.size(), nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+                    MyEdge &edge = undirected[i];
+                    edge = {std::max(edge.from, edge.to), std::min(edge.from, edge.to), edge.weight};
+                }
+            });
 
-            std::set<uint> nodes;
-            std::set<MyEdge> edges;
+            parallel_compact(undirected, [&undirected](size_t i) { return undirected[i].from != undirected[i].to; }, nw);
 
-            // Deleted first four lines of file, contains the information above
-            while (infile >> a >> b >> c) {
+            sort_unique_edges(undirected, nw);
 
-                float variance = MIN + (double)(rand()) / ((double)(RAND_MAX/(MAX - MIN)));
+            unmap();
 
-                float weight = c + variance;
+            this->edges.swap(undirected);
+            std::vector<MyEdge>().swap(undirected);
 
-                if (filename == "data/sc-rel9.edges") {
-                    a = a-1;
-                    b = b-1;
-                }
+            size_t n = this->edges.size();
 
-                if (a != b) {
-                    edges.insert({a, b, weight});
-                    edges.insert({b, a, weight});
+            std::vector<uint> endpoints (2 * n);
 
-                    nodes.insert(a);
-                    nodes.insert(b);
+            parallel_chunks(n, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+                    endpoints[2*i] = this->edges[i].from;
+                    endpoints[2*i + 1] = this->edges[i].to;
                 }
+            });
 
-            }
+            sort_unique_nodes(endpoints, nw);
 
-            this->nodes.assign(nodes.begin(), nodes.end());
-            this->edges.assign(edges.begin(), edges.end());
+            this->nodes.swap(endpoints);
 
-            this->originalNodes = this->nodes.size();
+            // Node ids index the per-node arrays of the drivers, so they must fit the id range even if some id is missing
+            this->originalNodes = this->nodes.empty() ? 0 : this->nodes.back() + 1;
 
         }
 
 
-
         /**
-         * @brief Load unweighted graph from filename, by filling the vector of Edge above
+         * @brief Load graph from textfile, by filling the vector of Edges above
+         * 
+         * @param filename the file to load
+         * @param format name of the format (see formats.hpp), detected from the file if empty
+         * @param seed seed of the random weights
+         * @param jitter if true, weighted files get a perturbation in [-1, 1) added to each weight
+         * @param minima if not NULL, filled with the minimum edge of each node (see below)
+         * 
+         * The file is memory mapped and parsed in parallel. Weights are kept as they are, ties included: they are
+         * broken on the edge ids (see lighter). Unweighted files get a random weight in [0, 10), and with jitter
+         * weighted ones a random perturbation, both drawn from a counter based stream indexed by the pair of nodes,
+         * so the result does not depend on the order of the edges or on the workers.
+         * 
+         * Each worker folds the blocks it parses into its own array of minimum edges while the other workers are
+         * still parsing: when minima is given, on return it holds the minimum edge starting from each node in the
+         * order of lighter(), which is what the first map phase of a Boruvka round over the loaded edges computes.
          */ 
-        void loadGraphUnweighted(std::string filename) {
+        void loadGraph(std::string filename, std::string format = "", uint64_t seed = 1, bool jitter = false, std::vector<IdEdge> *minima = NULL) {
 
-            std::ifstream infile(filename);
+            uint nw = default_workers();
 
-            const int MIN = 0;
-            const int MAX = 10;
+            const MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
 
-            uint a, b;
+            std::vector<std::vector<MyEdge>> parts (nw);
 
-            std::set<uint> nodes;
-            std::set<MyEdge> edges;
+            std::vector<std::vector<MyEdge>> local_minima (minima != NULL ? nw : 0);
 
-            // Deleted first four lines of file, contains the information above
-            while (infile >> a >> b) {
+            // Order of lighter() before the ids are assigned: the ids follow the order of the pairs of nodes
+            auto folded_lighter = [](const MyEdge &x, const MyEdge &y) {
+                if (x.weight != y.weight)
+                    return x.weight < y.weight;
+                uint xa = std::max(x.from, x.to), ya = std::max(y.from, y.to);
+                return xa < ya || (xa == ya && std::min(x.from, x.to) < std::min(y.from, y.to));
+            };
 
-                float weight = MIN + (double)(rand()) / ((double)(RAND_MAX/(MAX - MIN)));
+            {
+                MappedFile file(filename);
 
-                a = a-1;
-                b = b-1;
+                const formats::Format &reader = format.empty() ? formats::detect(filename, file.data(), file.size()) : formats::find(format);
 
-                if (a != b) {
+                bool weighted = reader.weighted(file.data(), file.size());
 
-                    edges.insert({a, b, weight});
-                    edges.insert({b, a, weight});
+                const CounterRNG weight_stream (seed, 40);
 
-                    nodes.insert(a);
-                    nodes.insert(b);
+                const bool perturbed = jitter || !weighted;
 
-                }
+                const int MIN = weighted ? -1 : 0;
+                const int MAX = weighted ? 1 : 10;
+
+                reader.parse(file.data(), file.size(), nw, [&](uint index, std::vector<MyEdge> &block) {
+
+                    std::vector<MyEdge> &undirected = parts[index];
+
+                    for (auto &edge : block) {
+
+                        uint a = std::max(edge.from, edge.to);
+                        uint b = std::min(edge.from, edge.to);
+
+                        if (a == b)
+                            continue;
+
+                        float weight = edge.weight;
+
+                        if (perturbed)
+                            weight += MIN + (MAX - MIN) * weight_stream.uniform((static_cast<uint64_t>(a) << 32) | b);
+
+                        undirected.push_back({a, b, weight});
+
+                        if (minima != NULL) {
+
+                            std::vector<MyEdge> &local = local_minima[index];
 
+                            if (a >= local.size())
+                                local.resize(std::max<size_t>(a + 1, 2 * local.size()), NULL_CONN);
+
+                            if (folded_lighter({a, b, weight}, local[a]))
+                                local[a] = {a, b, weight};
+
+                            if (folded_lighter({b, a, weight}, local[b]))
+                                local[b] = {b, a, weight};
+
+                        }
+
+                    }
+
+                });
             }
 
-            this->nodes.assign(nodes.begin(), nodes.end());
-            this->edges.assign(edges.begin(), edges.end());
+            // Gather the edges of the workers
+            std::vector<size_t> offsets (nw + 1, 0);
+
+            for (uint i = 0; i < nw; i++)
+                offsets[i+1] = offsets[i] + parts[i].size();
+
+            std::vector<MyEdge> undirected (offsets[nw]);
+
+            parallel_chunks(nw, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+                    std::copy(parts[i].begin(), parts[i].end(), undirected.begin() + offsets[i]);
+                    std::vector<MyEdge>().swap(parts[i]);
+                }
+            });
+
+            this->buildFrom(undirected);
+
+            if (minima != NULL) {
+
+                minima->assign(this->originalNodes, IdEdge{NULL_CONN, 0});
 
-            this->originalNodes = this->getNumNodes();
+                parallel_chunks(this->originalNodes, nw, [&](size_t begin, size_t end, uint) {
+
+                    for (auto &local : local_minima)
+                        for (size_t i = begin; i < std::min(end, local.size()); i++)
+                            if (folded_lighter(local[i], (*minima)[i]))
+                                (*minima)[i] = IdEdge{local[i], 0};
+
+                    // The edges were folded before having an id: look them up in the sorted list
+                    for (size_t i = begin; i < end; i++) {
+                        IdEdge &edge = (*minima)[i];
+                        if (!(edge == NULL_CONN)) {
+                            MyEdge canonical = {std::max(edge.from, edge.to), std::min(edge.from, edge.to), edge.weight};
+                            edge.id = std::lower_bound(this->edges.begin(), this->edges.end(), canonical) - this->edges.begin();
+                        }
+                    }
+
+                });
+
+            }
 
         }
 
         
 
+        /**
+         * @brief Load graph from a binary snapshot previously written by saveSnapshot
+         * 
+         * The snapshot is mapped read-only and kept mapped by the graph: getNodes() and getEdges() read its tables in
+         * place, and the pages are only loaded when the rounds first read them. A table stops being read from the
+         * snapshot when it is replaced by updateNodes or updateEdges, the copies of the graph share the mapping.
+         */
+        void loadSnapshot(std::string filename) {
+
+            snapshot = std::make_shared<Snapshot>(filename);
+            mappedNodes = mappedEdges = true;
+
+            this->nodes.clear();
+            this->edges.clear();
+
+            this->originalNodes = snapshot->originalNodes();
+
+        }
+
+
+        /**
+         * @brief Load only the node table of a snapshot, read in place as in loadSnapshot; edges are left on disk (see ExternalBoruvka)
+         */
+        void loadSnapshotNodes(std::string filename) {
+
+            snapshot = std::make_shared<Snapshot>(filename);
+            mappedNodes = true;
+            mappedEdges = false;
+
+            this->nodes.clear();
+            this->edges.clear();
+
+            this->originalNodes = snapshot->originalNodes();
+
+        }
+
+
+        /**
+         * @brief Write the current graph to a binary snapshot
+         */
+        void saveSnapshot(std::string filename) {
+            write_snapshot(filename, getNodes(), getEdges(), this->originalNodes);
+        }
+
+
+
         /**
          * @brief Randomly generate a graph given n nodes, and e edges
          * 
+         * @param n number of nodes
+         * @param e number of (directed) edges
+         * @param seed seed of the random streams
+         * @param weights distribution of the weights
+         * @param nw number of workers
+         * 
+         * Candidate k is drawn from position k of three counter based streams (endpoints and weight), and candidates are
+         * generated in parallel in batches. Self loops are rejected, duplicates keep the candidate with the smallest k and
+         * the first e/2 distinct edges in candidate order are kept. The graph only depends on n, e and seed: it is the
+         * same for every number of workers and every platform.
          */
-        void generateGraph(int n, long unsigned int e /*vertices number*/) {
+        void generateGraph(int n, long unsigned int e /*vertices number*/, uint64_t seed = 1, WeightDistribution weights = WeightDistribution::UNIFORM, uint nw = default_workers()) {
 
-            const int MIN = 1;
-            const int MAX = 10;
+            // Candidate edge (x > y) together with the position at which it has been drawn
+            struct Candidate {
+                MyEdge edge;
+                uint position;
+            };
 
-            std::set<uint> nodes;
-            std::set<MyEdge> edges;
+            const CounterRNG from_stream (seed, 0);
+            const CounterRNG to_stream (seed, 1);
+            const CounterRNG weight_stream (seed, 2);
 
-            while (edges.size() < e) {
-                uint x = rand() % n;
-                uint y = rand() % n;
+            // Each undirected edge accounts for two directed edges
+            size_t target = (e + 1) / 2;
 
-                if (y < x) {
+            std::vector<Candidate> unique;
 
-                    float weight = MIN + (double)(rand()) / ((double)(RAND_MAX/(MAX - MIN)));
+            size_t drawn = 0;
 
-                    edges.insert({x, y, weight});
-                    edges.insert({y, x, weight});
-                    
-                    nodes.insert(x);
-                    nodes.insert(y);
+            while (unique.size() < target) {
+
+                size_t missing = target - unique.size();
+                size_t batch = missing + missing / 8 + 16;
+
+                size_t previous = unique.size();
+                unique.resize(previous + batch);
+
+                parallel_chunks(batch, nw, [&](size_t begin, size_t end, uint) {
+                    for (size_t i = begin; i < end; i++) {
+
+                        uint64_t k = drawn + i;
+
+                        uint x = from_stream.bounded(k, n);
+                        uint y = to_stream.bounded(k, n);
+
+                        float weight = draw_weight(weights, weight_stream, k);
+
+                        // Self loops are marked with an invalid position and dropped below
+                        unique[previous + i] = {{std::max(x, y), std::min(x, y), weight}, x == y ? UINT32_MAX : static_cast<uint>(k)};
+
+                    }
+                });
+
+                drawn += batch;
+
+                // Keep the first drawn occurrence of every edge, candidates are stored in drawing order
+                parallel_radix_sort(unique, [](const Candidate &c) { return edge_key(c.edge); }, 64, nw);
+
+                parallel_compact(unique, [&unique](size_t i) {
+                    return unique[i].position != UINT32_MAX && (i == 0 || !(unique[i].edge == unique[i-1].edge));
+                }, nw);
+
+                // The survivors must be in drawing order before the next batch is appended
+                parallel_radix_sort(unique, [](const Candidate &c) { return static_cast<uint64_t>(c.position); }, 32, nw);
 
-                }
             }
 
-            this->nodes.assign(nodes.begin(), nodes.end());
-            this->edges.assign(edges.begin(), edges.end());
+            if (target == 0) {
+                unmap();
+                this->nodes.clear();
+                this->edges.clear();
+                this->originalNodes = 0;
+                return;
+            }
+
+            // Only the first target distinct edges, in drawing order, are kept
+            unique.resize(target);
+
+            std::vector<MyEdge> undirected (target);
+
+            parallel_chunks(target, nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++)
+                    undirected[i] = unique[i].edge;
+            });
+
+            std::vector<Candidate>().swap(unique);
+
+            this->buildFrom(undirected);
 
             // // Uncomment this section to save the graph to textfile
             // std::ofstream file ("graph.txt");
@@ -197,12 +443,92 @@ class Graph {
 
             // file.close();
 
-            this->originalNodes = this->nodes.size();
+        }
+
+        /**
+         * @brief Generate a graph with one of the workload generators of generators.hpp
+         * 
+         * @param spec the generator specification, "gen:<kind>[:<weights>]"
+         * @param n requested number of nodes
+         * @param e requested number of (directed) edges
+         * @param seed seed of the random streams
+         * 
+         * - uniform: same as generateGraph
+         * - rmat: 2^ceil(log2 n) nodes and e/2 drawn edges, duplicates and self loops are dropped
+         * - grid2d, torus2d: sqrt(n) x sqrt(n) mesh, e is ignored
+         * - grid3d, torus3d: cbrt(n) x cbrt(n) x cbrt(n) mesh, e is ignored
+         * - ba: n nodes, each one attached to e/(2n) earlier nodes (at least 1)
+         */
+        void generateGraph(const std::string &spec, int n, long unsigned int e, uint64_t seed = 1) {
+
+            GeneratorSpec generator = parse_generator(spec);
+
+            uint nw = default_workers();
+
+            std::vector<MyEdge> undirected;
+
+            switch (generator.kind) {
+
+                case GeneratorKind::UNIFORM:
+                    this->generateGraph(n, e, seed, generator.weights, nw);
+                    return;
+
+                case GeneratorKind::RMAT: {
+                    uint scale = 0;
+                    while ((1ULL << scale) < static_cast<uint64_t>(n))
+                        scale++;
+                    undirected = rmat_edges(scale, e / 2, 0.57, 0.19, 0.19, generator.weights, seed, nw);
+                    break;
+                }
+
+                case GeneratorKind::GRID2D:
+                case GeneratorKind::TORUS2D: {
+                    uint side = std::max(1.0, std::round(std::sqrt(static_cast<double>(n))));
+                    undirected = grid_edges({side, side}, generator.kind == GeneratorKind::TORUS2D, generator.weights, seed, nw);
+                    break;
+                }
+
+                case GeneratorKind::GRID3D:
+                case GeneratorKind::TORUS3D: {
+                    uint side = std::max(1.0, std::round(std::cbrt(static_cast<double>(n))));
+                    undirected = grid_edges({side, side, side}, generator.kind == GeneratorKind::TORUS3D, generator.weights, seed, nw);
+                    break;
+                }
+
+                case GeneratorKind::BA: {
+                    uint m = std::max(1UL, e / (2 * static_cast<long unsigned int>(std::max(n, 1))));
+                    undirected = barabasi_albert_edges(n, m, generator.weights, seed, nw);
+                    break;
+                }
+
+            }
+
+            this->buildFrom(undirected);
 
         }
 
         friend std::ostream& operator<< (std::ostream& out, const Graph& graph);
 
+    private:
+
+        // Snapshot the graph was loaded from, mapped as long as one of its tables is read in place (see loadSnapshot)
+        std::shared_ptr<Snapshot> snapshot;
+
+        bool mappedNodes = false;
+
+        bool mappedEdges = false;
+
+        // Unmap the snapshot once neither table is read from it
+        void release() {
+            if (!mappedNodes && !mappedEdges)
+                snapshot.reset();
+        }
+
+        // Stop reading the snapshot, before the vectors are filled from another source
+        void unmap() {
+            mappedNodes = mappedEdges = false;
+            snapshot.reset();
+        }
 
 };
 
@@ -211,7 +537,7 @@ std::ostream& operator<<(std::ostream& os, const Graph& graph) {
 
     os << "Node set" << std::endl;
 
-    for (auto &node : graph.nodes) {
+    for (auto &node : graph.getNodes()) {
         os << node << std::endl;
     }
 
@@ -219,7 +545,7 @@ std::ostream& operator<<(std::ostream& os, const Graph& graph) {
 
     os << "Edges set" << std::endl;
 
-    for (auto &edge : graph.edges) {
+    for (auto &edge : graph.getEdges()) {
         os << "Node from " << edge.from << " to " << edge.to << " with weight " << edge.weight << std::endl;
     }
 
@@ -227,4 +553,151 @@ std::ostream& operator<<(std::ostream& os, const Graph& graph) {
 
 }
 
+
+/**
+ * @brief Working graph of a run of the Boruvka rounds, over a loaded graph that is never modified
+ *
+ * The first round reads the nodes and edges of the loaded graph in place. The surviving edges of every round are
+ * written into one of two scratch buffers, the one the round is not reading, and become the edges of the next
+ * round; their ids are written at the same positions into the id buffer paired with it (see EdgeIds), the nodes
+ * are renumbered into a third buffer. reset() starts a new run on the loaded graph: nothing is
+ * copied and the buffers keep their capacity, so repeated runs on the same graph only pay for the rounds, and the
+ * buffers never hold more than the survivors of the first two rounds.
+ */
+class GraphView {
+
+    public:
+
+        // Size of the node id range of the current round
+        uint originalNodes;
+
+        GraphView(const Graph &base) : base(&base) {
+            reset();
+        }
+
+        /**
+         * @brief Start a new run on the loaded graph
+         */
+        void reset() {
+            current = written = BASE;
+            nodes_renumbered = false;
+            originalNodes = base->originalNodes;
+        }
+
+        ArrayRef<uint> nodes() const {
+            if (nodes_renumbered)
+                return renumbered;
+            return base->getNodes();
+        }
+
+        ArrayRef<MyEdge> edges() const {
+            if (current == BASE)
+                return base->getEdges();
+            return buffers[current];
+        }
+
+        // Ids of the edges, implicit for the loaded ones
+        EdgeIds ids() const {
+            if (current == BASE)
+                return EdgeIds();
+            return id_buffers[current].data();
+        }
+
+        uint getNumNodes() const {
+            return this->nodes().size();
+        }
+
+        uint getNumEdges() const {
+            return this->edges().size();
+        }
+
+        /**
+         * @brief Buffer receiving the surviving edges of the round, resized to n edges
+         *
+         * @param in_place return the edges of the round themselves, without resizing them, when they are already a scratch
+         *        buffer: for the filters that compact the edges in place, never writing ahead of the edge being read
+         *
+         * The buffer becomes the edges of the view with useSurvivors(), the ids of the survivors go into survivorIds().
+         * Their entries are left uninitialized (see EdgeBuffer), within the capacity reached by the previous rounds and
+         * runs the resize costs nothing
+         */
+        EdgeBuffer &survivors(size_t n, bool in_place = false) {
+
+            if (in_place && current != BASE) {
+                written = current;
+                return buffers[written];
+            }
+
+            written = current == 0 ? 1 : 0;
+
+            buffers[written].resize(n);
+            id_buffers[written].resize(n);
+
+            return buffers[written];
+
+        }
+
+        // Ids of the edges written into the buffer of survivors(), at the same positions and of the same size
+        IdBuffer &survivorIds() {
+            return id_buffers[written];
+        }
+
+        // The edges written into the buffer of survivors() become the edges of the view
+        void useSurvivors() {
+            current = written;
+        }
+
+        /**
+         * @brief Writable copy of the edges with their ids, for the engines that rearrange them (e.g. Filter-Kruskal)
+         *
+         * The copy is kept by the view, the next runs refill it within its capacity
+         */
+        IdEdgeBuffer &ownEdges() {
+
+            ArrayRef<MyEdge> edges = this->edges();
+            EdgeIds ids = this->ids();
+
+            owned.resize(edges.size());
+
+            for (size_t i = 0; i < edges.size(); i++)
+                owned[i] = {edges[i], ids[i]};
+
+            return owned;
+
+        }
+
+        /**
+         * @brief Replace the nodes with the dense ids 0 to n-1, after the edges have been relabeled (see relabel.hpp)
+         */
+        void renumberNodes(uint n) {
+            renumbered.resize(n);
+            std::iota(renumbered.begin(), renumbered.end(), 0);
+            originalNodes = n;
+            nodes_renumbered = true;
+        }
+
+    private:
+
+        static const int BASE = -1;
+
+        const Graph *base;
+
+        // Scratch buffers of the edges and of their ids, and the nodes once renumbered
+        EdgeBuffer buffers[2];
+
+        IdBuffer id_buffers[2];
+
+        IdEdgeBuffer owned;
+
+        std::vector<uint> renumbered;
+
+        bool nodes_renumbered;
+
+        // Buffer of the current edges and of the survivors of the round, BASE for the loaded edges
+        int current;
+
+        int written;
+
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#if !defined(__INCREMENTAL_H)
+#define __INCREMENTAL_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "utils.hpp"
+#include "dset.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+#include "relabel.hpp"
+#include "sort.hpp"
+#include "mst.hpp"
+
+/**
+ * @brief Batched insertion of edges into a minimum spanning forest
+ *
+ * An edge out of the forest of a graph is the heaviest edge of some cycle of the graph (cycle property), and
+ * it still is once more edges are added: the forest of the graph with a batch of new edges is the forest of
+ * the old tree edges with the batch. An insertion runs the Boruvka rounds on those edges only, so it costs
+ * O(n + b) per round for a forest of n nodes and a batch of b edges, whatever the number of edges of the graph.
+ *
+ * The ties are broken as in lighter(): the candidate edges get the ids of their positions in the candidate
+ * list, sorted by (from, to) as the loaded graph is, so among them the order is the one of the whole graph
+ * and the forest is the one a run from scratch would find.
+ */
+class IncrementalMST {
+
+    public:
+
+        /**
+         * @param nw number of workers of the rounds, the threads of the engine are started once for all its insertions
+         */
+        IncrementalMST(uint nw) : nw(nw), own_pool(nw > 1 ? new ThreadPool(nw) : nullptr), pool(own_pool.get()), view(graph) {}
+
+        /**
+         * @param pool threads of the caller running the rounds, at least nw of them
+         * @param nw number of workers of the rounds
+         */
+        IncrementalMST(ThreadPool &pool, uint nw) : nw(nw), pool(&pool), view(graph) {}
+
+        // The view refers to the candidates of the engine
+        IncrementalMST(const IncrementalMST &) = delete;
+        IncrementalMST &operator=(const IncrementalMST &) = delete;
+
+        /**
+         * @brief Replace a forest with the forest of its edges and a batch of new edges
+         *
+         * @param mst the forest, its edges and weight are updated (the trees are not, see MST::findTrees)
+         * @param batch the new edges, in any orientation; of several copies of an edge only the lightest is kept
+         * @return int the number of rounds performed
+         *
+         * The edges of the updated forest are sorted by (from, to), their ids are the positions in the candidate
+         * list of the insertion. The buffers of the rounds are kept by the engine for its next insertions.
+         */
+        int insert(MST &mst, ArrayRef<MyEdge> batch) {
+
+            candidates(mst.edges, batch);
+
+            // The nodes are the endpoints of the candidates: isolated nodes would stay components in every round
+            graph.originalNodes = 0;
+
+            for (auto &edge : graph.edges)
+                graph.originalNodes = std::max(graph.originalNodes, edge.from + 1);
+
+            endpoint.assign(graph.originalNodes, 0);
+
+            for (auto &edge : graph.edges)
+                endpoint[edge.from] = endpoint[edge.to] = 1;
+
+            graph.nodes.clear();
+
+            for (uint node = 0; node < graph.originalNodes; node++)
+                if (endpoint[node])
+                    graph.nodes.push_back(node);
+
+            // The rounds work on the view, the forest is resolved against the candidates as they are
+            view.reset();
+
+            DisjointSets components (view.originalNodes);
+
+            recorder.reset(nw);
+
+            local_edges.resize(nw);
+
+            const IdEdge NULL_CONN = {0, 0, MAX_WEIGHT};
+
+            int rounds = 0;
+
+            while (view.getNumNodes() > 1 && view.getNumEdges() != 0) {
+
+                ArrayRef<MyEdge> edges = view.edges();
+
+                EdgeIds ids = view.ids();
+
+                // A round too small to be split runs on one worker: handing its passes to the pool costs more than them
+                workers = view.getNumEdges() + view.originalNodes < PARALLEL_CANDIDATES ? 1 : nw;
+
+                // Minimum edge of each node, each edge is a candidate for both its endpoints
+                for (uint w = 0; w < workers; w++)
+                    local_edges[w].assign(view.originalNodes, NULL_CONN);
+
+                chunks(view.getNumEdges(), [&](size_t begin, size_t end, uint thid) {
+                    for (size_t i = begin; i < end; i++)
+                        offer_edge(local_edges[thid], edges[i], ids, i);
+                });
+
+                global_edges.assign(view.originalNodes, NULL_CONN);
+
+                chunks(view.originalNodes, [&](size_t begin, size_t end, uint) {
+                    for (uint w = 0; w < workers; w++)
+                        for (size_t i = begin; i < end; i++)
+                            if (lighter(local_edges[w][i], global_edges[i]))
+                                global_edges[i] = local_edges[w][i];
+                });
+
+                // Contraction
+                chunks(view.originalNodes, [&](size_t begin, size_t end, uint thid) {
+                    for (size_t i = begin; i < end; i++) {
+                        IdEdge edge = global_edges[i];
+                        if (!(edge == NULL_CONN) && components.merge(edge.from, edge.to))
+                            recorder.record(thid, edge.id);
+                    }
+                });
+
+                // Nothing to contract although edges are left (e.g. NaN weights, never picked)
+                if (recorder.endRound() == 0)
+                    break;
+
+                // Filtering of the nodes: the components left are numbered densely (see relabel.hpp)
+                relabeling.reset(view.originalNodes, workers);
+
+                chunks(view.getNumNodes(), [&](size_t begin, size_t end, uint thid) {
+                    relabeling.countRoots(components, view.nodes(), begin, end, thid);
+                });
+
+                relabeling.prefixSum();
+
+                chunks(view.getNumNodes(), [&](size_t begin, size_t end, uint thid) {
+                    relabeling.assignLabels(components, view.nodes(), begin, end, thid);
+                });
+
+                chunks(view.originalNodes, [&](size_t begin, size_t end, uint) {
+                    relabeling.flatten(components, begin, end);
+                });
+
+                // Filtering of the edges, over the new ids: every chunk counts its survivors, then writes them from the prefix sum of the counts
+                survivors.assign(workers + 1, 0);
+
+                chunks(view.getNumEdges(), [&](size_t begin, size_t end, uint thid) {
+                    size_t count = 0;
+                    for (size_t i = begin; i < end; i++) {
+                        MyEdge edge = edges[i];
+                        count += relabeling.relabel(edge);
+                    }
+                    survivors[thid + 1] = count;
+                });
+
+                for (uint w = 0; w < workers; w++)
+                    survivors[w + 1] += survivors[w];
+
+                EdgeBuffer &next_edges = view.survivors(survivors[workers]);
+
+                IdBuffer &next_ids = view.survivorIds();
+
+                chunks(view.getNumEdges(), [&](size_t begin, size_t end, uint thid) {
+                    size_t position = survivors[thid];
+                    for (size_t i = begin; i < end; i++) {
+                        MyEdge edge = edges[i];
+                        if (relabeling.relabel(edge)) {
+                            next_ids[position] = ids[i];
+                            next_edges[position++] = edge;
+                        }
+                    }
+                });
+
+                view.useSurvivors();
+
+                view.renumberNodes(relabeling.numLabels());
+
+                // The next round works on the new ids
+                components = DisjointSets(view.originalNodes);
+
+                rounds++;
+
+            }
+
+            MST updated = recorder.resolve(graph.edges);
+
+            mst.edges.swap(updated.edges);
+            mst.weight = updated.weight;
+
+            return rounds;
+
+        }
+
+    private:
+
+        // Smallest round (edges plus node ids) split among the workers
+        static const size_t PARALLEL_CANDIDATES = 1 << 16;
+
+        uint nw;
+
+        // Workers of the current round, 1 or nw
+        uint workers;
+
+        std::unique_ptr<ThreadPool> own_pool;
+
+        ThreadPool *pool;
+
+        // Candidate edges of the insertion and their endpoints, the rounds run on a view of them
+        Graph graph;
+
+        std::vector<char> endpoint;
+
+        GraphView view;
+
+        // Buffers of the rounds
+        MSTRecorder recorder;
+
+        std::vector<std::vector<IdEdge>> local_edges;
+        std::vector<IdEdge> global_edges;
+
+        // Surviving edges of each chunk, then written into the buffer of the view the round is not reading
+        std::vector<size_t> survivors;
+
+        Relabeling relabeling;
+
+        std::vector<MyEdge> added;
+        std::vector<MyEdge> sorted;
+
+        /**
+         * @brief Run f(begin, end, thid) on the chunks of [0, n) of the workers of the round, on the threads of the pool
+         */
+        template <typename F>
+        void chunks(size_t n, F f) {
+            if (workers <= 1)
+                f(static_cast<size_t>(0), n, 0);
+            else
+                parallel_chunks(*pool, n, workers, f);
+        }
+
+        /**
+         * @brief Merge the edges of the forest with the batch into the candidates, sorted by (from, to): their ids are their positions
+         *
+         * Only the batch is sorted: the edges of a forest resolved by an MSTRecorder are in id order, hence in
+         * (from, to) order (they are sorted otherwise).
+         */
+        void candidates(const std::vector<MyEdge> &tree, ArrayRef<MyEdge> batch) {
+
+            added.clear();
+
+            added.reserve(batch.size());
+
+            for (auto &edge : batch)
+                if (edge.from != edge.to)
+                    added.push_back({std::max(edge.from, edge.to), std::min(edge.from, edge.to), edge.weight});
+
+            // The sort starts its own threads, only worth it on a large batch
+            sort_unique_edges(added, added.size() < PARALLEL_CANDIDATES ? 1 : nw);
+
+            const std::vector<MyEdge> *old = &tree;
+
+            if (!std::is_sorted(tree.begin(), tree.end())) {
+                sorted = tree;
+                std::sort(sorted.begin(), sorted.end());
+                old = &sorted;
+            }
+
+            std::vector<MyEdge> &merged = graph.edges;
+
+            merged.clear();
+
+            merged.reserve(old->size() + added.size());
+
+            size_t i = 0, j = 0;
+
+            while (i < old->size() || j < added.size()) {
+
+                if (j == added.size() || (i < old->size() && (*old)[i] < added[j]))
+                    merged.push_back((*old)[i++]);
+                else if (i == old->size() || added[j] < (*old)[i])
+                    merged.push_back(added[j++]);
+                else {
+                    // The same edge in the forest and in the batch: keep the lightest copy
+                    merged.push_back((*old)[i].weight <= added[j].weight ? (*old)[i] : added[j]);
+                    i++;
+                    j++;
+                }
+
+            }
+
+        }
+
+};
+
+#endif
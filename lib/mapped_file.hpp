@@ -0,0 +1,103 @@
+#if !defined(__MAPPED_FILE_H)
+#define __MAPPED_FILE_H
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <cstddef>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Read-only memory mapping of a whole file (RAII)
+ *
+ * The file is mapped at construction and unmapped at destruction. The kernel is advised that the
+ * mapping is going to be read sequentially, so that read-ahead can be as aggressive as possible.
+ */
+class MappedFile {
+
+    public:
+
+        /**
+         * @brief Map the given file in memory
+         *
+         * @param filename path of the file to map
+         *
+         * Throws std::runtime_error if the file cannot be opened or mapped
+         */
+        MappedFile(const std::string &filename) {
+
+            fd = open(filename.c_str(), O_RDONLY);
+
+            if (fd < 0)
+                throw std::runtime_error("cannot open " + filename);
+
+            struct stat info;
+
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw std::runtime_error("cannot stat " + filename);
+            }
+
+            length = static_cast<size_t>(info.st_size);
+
+            if (length > 0) {
+
+                void *addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (addr == MAP_FAILED) {
+                    close(fd);
+                    throw std::runtime_error("cannot map " + filename);
+                }
+
+                // The advice values are not flags, each one takes its own call
+                advise(addr, MADV_SEQUENTIAL, "MADV_SEQUENTIAL", filename);
+                advise(addr, MADV_WILLNEED, "MADV_WILLNEED", filename);
+
+                base = static_cast<const char *>(addr);
+
+            }
+
+        }
+
+        ~MappedFile() {
+            if (base != NULL)
+                munmap(const_cast<char *>(base), length);
+            if (fd >= 0)
+                close(fd);
+        }
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Pointer to the first byte of the file
+        const char *data() const { return base; }
+
+        // Size of the file in bytes
+        size_t size() const { return length; }
+
+    private:
+
+        /**
+         * @brief Give one hint about the mapping to the kernel
+         *
+         * A hint that is refused only costs read-ahead, so the mapping is still usable and the failure is just reported
+         */
+        void advise(void *addr, int advice, const char *name, const std::string &filename) {
+            if (madvise(addr, length, advice) != 0)
+                std::cerr << "madvise(" << name << ") failed on " << filename << ": " << strerror(errno) << std::endl;
+        }
+
+        int fd = -1;
+
+        const char *base = NULL;
+
+        size_t length = 0;
+
+};
+
+#endif
@@ -0,0 +1,105 @@
+#if !defined(__MINIMA_H)
+#define __MINIMA_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include "utils.hpp"
+#include "sort.hpp"
+
+/**
+ * @brief Shared array of the minimum edge of each node, updated with a lock-free write-min
+ *
+ * The candidate edge of a node is packed into a single 64 bit word: the order preserving key of its weight
+ * in the upper half, its index in the edge list in the lower half. Comparing packed words compares the
+ * weights first and breaks ties on the lowest index, so every worker can offer its edges straight into the
+ * shared slots with a compare-and-swap loop, and the result does not depend on the order of the updates.
+ * The edge lists keep the edges in id order through the rounds (the filters preserve the order of the
+ * survivors), so the lowest index is the lowest id and the order is the one of lighter().
+ *
+ * This replaces the per-worker copies of the minimum edges (nw arrays as large as the node id range) and
+ * the pass merging them.
+ */
+class PackedMinima {
+
+    public:
+
+        // Slot of the nodes without any candidate edge, greater than any packed edge
+        static constexpr uint64_t EMPTY = UINT64_MAX;
+
+        /**
+         * @brief Construct the slots of a node id range of at most capacity nodes
+         *
+         * The slots are allocated once, the following rounds work on smaller (relabeled) ranges
+         */
+        PackedMinima(uint capacity = 0) : slots(capacity) {}
+
+        // Number of slots
+        uint capacity() const { return slots.size(); }
+
+        /**
+         * @brief Empty the slots of the nodes [begin, end)
+         */
+        void reset(uint begin, uint end) {
+            for (uint node = begin; node < end; node++)
+                slots[node].store(EMPTY, std::memory_order_relaxed);
+        }
+
+        static uint64_t pack(float weight, uint index) {
+            return (static_cast<uint64_t>(weight_key(weight)) << 32) | index;
+        }
+
+        /**
+         * @brief Write-min of a packed candidate into the slot of a node
+         */
+        void offer(uint node, uint64_t packed) {
+
+            uint64_t current = slots[node].load(std::memory_order_relaxed);
+
+            // A failed exchange reloads current, retry while the candidate is still lighter
+            while (packed < current && !slots[node].compare_exchange_weak(current, packed, std::memory_order_relaxed)) {}
+
+        }
+
+        /**
+         * @brief Offer the undirected edge number index as the minimum edge of both its endpoints
+         */
+        void offerEdge(const MyEdge &edge, uint index) {
+
+            uint64_t packed = pack(edge.weight, index);
+
+            offer(edge.from, packed);
+            offer(edge.to, packed);
+
+        }
+
+        /**
+         * @brief Unpack the minimum edge of a node, oriented from the node
+         *
+         * @param edges the edge list whose indexes have been offered, either a vector of MyEdge or EdgeArrays
+         * @param ids the ids of the edge list
+         * @return IdEdge the edge and its id, {0, 0, MAX_WEIGHT} if the node has no candidate
+         */
+        template <typename EdgesT>
+        IdEdge edgeOf(uint node, const EdgesT &edges, EdgeIds ids) const {
+
+            uint64_t packed = slots[node].load(std::memory_order_relaxed);
+
+            if (packed == EMPTY)
+                return {0, 0, MAX_WEIGHT};
+
+            uint index = static_cast<uint>(packed);
+
+            MyEdge edge = edges[index];
+
+            return {edge.from == node ? edge : MyEdge{edge.to, edge.from, edge.weight}, ids[index]};
+
+        }
+
+    private:
+
+        std::vector<std::atomic<uint64_t>> slots;
+
+};
+
+#endif
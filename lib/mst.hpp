@@ -0,0 +1,295 @@
+#if !defined(__MST_H)
+#define __MST_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include "utils.hpp"
+#include "sort.hpp"
+
+/**
+ * @brief Tree of a spanning forest, spanning one connected component of the graph
+ */
+struct Tree {
+
+    // Lowest node id of the component
+    uint first;
+
+    // Number of nodes of the component
+    uint nodes;
+
+    // Sum of the weights of the edges of the tree
+    double weight;
+
+};
+
+
+/**
+ * @brief Minimum spanning tree computed by a run, a spanning forest if the graph is not connected
+ */
+struct MST {
+
+    // Edges of the tree, as they are in the loaded graph, in id order
+    std::vector<MyEdge> edges;
+
+    // Sum of the weights of the edges
+    double weight = 0;
+
+    // Trees of the forest, by increasing lowest node id (filled by findTrees)
+    std::vector<Tree> trees;
+
+    /**
+     * @brief Split the forest into its trees, one per connected component of the graph
+     *
+     * @param nodes the nodes of the loaded graph, increasing
+     * @param numNodes size of the node id range
+     *
+     * The edges are united on a plain union-find with union by size and path halving, in almost linear time for a
+     * forest of n nodes
+     */
+    void findTrees(ArrayRef<uint> nodes, uint numNodes) {
+
+        std::vector<uint> parent (numNodes);
+        std::vector<uint> size (numNodes, 1);
+
+        for (uint node = 0; node < numNodes; node++)
+            parent[node] = node;
+
+        auto find = [&parent](uint node) {
+            while (parent[node] != node) {
+                parent[node] = parent[parent[node]];
+                node = parent[node];
+            }
+            return node;
+        };
+
+        for (auto &edge : edges) {
+
+            uint a = find(edge.from);
+            uint b = find(edge.to);
+
+            // The smaller tree hangs from the root of the larger one
+            if (size[a] < size[b])
+                std::swap(a, b);
+
+            parent[b] = a;
+            size[a] += size[b];
+
+        }
+
+        // Tree of each root, numbered when its lowest node is met
+        std::vector<uint> tree (numNodes, UINT32_MAX);
+
+        trees.clear();
+
+        for (uint node : nodes) {
+            uint root = find(node);
+            if (tree[root] == UINT32_MAX) {
+                tree[root] = trees.size();
+                trees.push_back({node, 0, 0});
+            }
+            trees[tree[root]].nodes++;
+        }
+
+        for (auto &edge : edges)
+            trees[tree[find(edge.from)]].weight += edge.weight;
+
+    }
+
+};
+
+
+/**
+ * @brief Edges added to the tree by the engines of a run, recorded by id
+ *
+ * The endpoints of an edge are rewritten over the ids of the components after every round, but its id stays
+ * the position of the edge in the loaded graph (see EdgeIds). Whenever an engine adds an edge to the tree (a unite linking
+ * two components, a node hooked to its minimum edge, an edge taken by a finish) it records the id into the
+ * buffer of its worker; the buffers of a round are appended to the tree when the round ends, so the threads
+ * never share a buffer. Once the run is over the ids are sorted and resolved against the loaded graph: with
+ * one entry per tree edge, the whole recording costs O(n) on top of the run.
+ */
+class MSTRecorder {
+
+    public:
+
+        /**
+         * @brief Start a new run with nw workers
+         */
+        void reset(uint nw) {
+            buffers.assign(nw, {});
+            ids.clear();
+        }
+
+        // Record the edge with the given id, added to the tree by the worker index
+        void record(uint index, uint id) {
+            buffers[index].push_back(id);
+        }
+
+        /**
+         * @brief Append the edges recorded by the workers during the round to the tree
+         *
+         * @return size_t the number of edges added by the round: a round adding none cannot make any progress
+         */
+        size_t endRound() {
+
+            size_t added = 0;
+
+            for (auto &buffer : buffers) {
+                ids.insert(ids.end(), buffer.begin(), buffer.end());
+                added += buffer.size();
+                buffer.clear();
+            }
+
+            return added;
+
+        }
+
+        // Number of edges of the tree
+        size_t size() const { return ids.size(); }
+
+        /**
+         * @brief Resolve the recorded ids against the loaded edges
+         *
+         * @param input the edges of the loaded graph indexed by id: a vector of MyEdge, EdgeArrays or the edge
+         *        table of a snapshot
+         */
+        template <typename EdgesT>
+        MST resolve(const EdgesT &input) {
+
+            sortIds();
+
+            MST mst;
+
+            mst.edges.resize(ids.size());
+
+            for (size_t i = 0; i < ids.size(); i++) {
+                mst.edges[i] = input[ids[i]];
+                mst.weight += mst.edges[i].weight;
+            }
+
+            return mst;
+
+        }
+
+        /**
+         * @brief Resolve the recorded ids against loaded edges that can only be scanned, not indexed
+         *
+         * @param numEdges number of edges of the loaded graph
+         * @param scan function called as scan(f), calling f(edge, id) on every loaded edge, in id order for the tree to come out in id order
+         */
+        template <typename ScanF>
+        MST resolveScan(size_t numEdges, ScanF scan) {
+
+            sortIds();
+
+            std::vector<char> selected (numEdges, 0);
+
+            for (uint id : ids)
+                selected[id] = 1;
+
+            MST mst;
+
+            mst.edges.reserve(ids.size());
+
+            scan([&](const MyEdge &edge, uint id) {
+                if (selected[id]) {
+                    mst.edges.push_back(edge);
+                    mst.weight += edge.weight;
+                }
+            });
+
+            return mst;
+
+        }
+
+    private:
+
+        // Edges recorded by each worker during the current round
+        std::vector<std::vector<uint>> buffers;
+
+        // Edges of the tree, from the rounds already over
+        std::vector<uint> ids;
+
+        // The order of the ids depends on the workers: once sorted, the tree and the order of the sum no longer do
+        void sortIds() {
+            endRound();
+            parallel_radix_sort(ids, [](uint id) { return static_cast<uint64_t>(id); }, 32, 1);
+        }
+
+};
+
+
+/**
+ * @brief Write the edges of a tree to a text file, one "from to weight" line per edge
+ */
+inline void write_mst(const std::string &filename, const MST &mst) {
+
+    FILE *file = fopen(filename.c_str(), "w");
+
+    if (file == NULL)
+        throw std::runtime_error("cannot create " + filename);
+
+    bool ok = true;
+
+    for (auto &edge : mst.edges)
+        ok = fprintf(file, "%u %u %.9g\n", edge.from, edge.to, edge.weight) > 0 && ok;
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+        throw std::runtime_error("cannot write " + filename);
+
+}
+
+
+/**
+ * @brief Write the trees of a forest to a text file, one "first_node nodes weight" line per tree (see findTrees)
+ */
+inline void write_forest(const std::string &filename, const MST &mst) {
+
+    FILE *file = fopen(filename.c_str(), "w");
+
+    if (file == NULL)
+        throw std::runtime_error("cannot create " + filename);
+
+    bool ok = true;
+
+    for (auto &tree : mst.trees)
+        ok = fprintf(file, "%u %u %.17g\n", tree.first, tree.nodes, tree.weight) > 0 && ok;
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+        throw std::runtime_error("cannot write " + filename);
+
+}
+
+
+/**
+ * @brief Print the size and weight of a forest, and its largest tree when there are several
+ */
+inline void print_mst(const MST &mst) {
+
+    std::cout << "mst: " << mst.edges.size() << " edges, weight " << std::to_string(mst.weight) << "; " << mst.trees.size() << " trees";
+
+    if (mst.trees.size() > 1) {
+
+        const Tree *largest = &mst.trees[0];
+
+        for (auto &tree : mst.trees)
+            if (tree.nodes > largest->nodes)
+                largest = &tree;
+
+        std::cout << ", largest " << largest->nodes << " nodes, weight " << std::to_string(largest->weight);
+
+    }
+
+    std::cout << std::endl;
+
+}
+
+#endif
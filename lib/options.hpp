@@ -0,0 +1,60 @@
+#if !defined(__OPTIONS_H)
+#define __OPTIONS_H
+
+#include <string>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+
+/**
+ * @brief Optional key=value arguments following the positional ones of the drivers
+ *
+ * e.g. ./build/boruvka_thread 8 0 0 graph.txt 5 save=graph.snap
+ */
+class Options {
+
+    public:
+
+        /**
+         * @brief Parse argv[first..argc)
+         *
+         * Arguments without an '=' are reported and ignored
+         */
+        Options(int argc, char *argv[], int first) {
+            for (int i = first; i < argc; i++) {
+                std::string arg = argv[i];
+                size_t eq = arg.find('=');
+                if (eq == std::string::npos || eq == 0) {
+                    std::cout << "Ignoring malformed option " << arg << " (expected key=value)" << std::endl;
+                    continue;
+                }
+                values[arg.substr(0, eq)] = arg.substr(eq + 1);
+            }
+        }
+
+        bool has(const std::string &key) const {
+            return values.count(key) != 0;
+        }
+
+        std::string get(const std::string &key, const std::string &fallback = "") const {
+            auto it = values.find(key);
+            return it == values.end() ? fallback : it->second;
+        }
+
+        long getLong(const std::string &key, long fallback) const {
+            auto it = values.find(key);
+            return it == values.end() ? fallback : std::atol(it->second.c_str());
+        }
+
+        double getDouble(const std::string &key, double fallback) const {
+            auto it = values.find(key);
+            return it == values.end() ? fallback : std::atof(it->second.c_str());
+        }
+
+    private:
+
+        std::unordered_map<std::string, std::string> values;
+
+};
+
+#endif
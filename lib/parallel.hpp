@@ -0,0 +1,92 @@
+#if !defined(__PARALLEL_H)
+#define __PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <future>
+#include <cstddef>
+#include <sys/types.h>
+#include "threadpool.hpp"
+
+/**
+ * @brief Number of workers used by the library routines (loading, sorting, generation)
+ *
+ * @return uint the hardware concurrency, or 1 if it cannot be detected
+ */
+inline uint default_workers() {
+    uint nw = std::thread::hardware_concurrency();
+    return nw == 0 ? 1 : nw;
+}
+
+
+/**
+ * @brief Split the interval [0, n) among nw workers and run the given function on each chunk
+ *
+ * @tparam F function type, called as f(begin, end, thid)
+ * @param n size of the interval
+ * @param nw number of workers
+ * @param f the function to execute on each chunk
+ *
+ * Chunks are computed as in the drivers: each worker receives n / nw indexes, the last one also takes the remainder.
+ * Chunk 0 is computed by the calling thread, the other ones by freshly spawned threads that are joined before returning.
+ */
+template <typename F>
+void parallel_chunks(size_t n, uint nw, F f) {
+
+    if (nw <= 1 || n < nw) {
+        f(static_cast<size_t>(0), n, 0);
+        return;
+    }
+
+    size_t chunk_dim = n / nw;
+
+    std::vector<std::thread> workers;
+    workers.reserve(nw - 1);
+
+    for (uint i = 1; i < nw; i++) {
+        size_t begin = i * chunk_dim;
+        size_t end = (i == nw - 1) ? n : begin + chunk_dim;
+        workers.emplace_back([&f, begin, end, i]() { f(begin, end, i); });
+    }
+
+    f(static_cast<size_t>(0), chunk_dim, 0);
+
+    for (auto &worker : workers)
+        worker.join();
+
+}
+
+
+/**
+ * @brief Same as parallel_chunks, on the threads of a pool instead of fresh ones
+ *
+ * @param pool the pool running the chunks, with at least nw threads
+ *
+ * Chunk i is run by the thread i of the pool and the call returns when all of them are done, so that the callers
+ * running many short passes (e.g. the rounds of an insertion) do not pay for a thread creation in each of them.
+ */
+template <typename F>
+void parallel_chunks(ThreadPool &pool, size_t n, uint nw, F f) {
+
+    if (nw <= 1 || n < nw) {
+        f(static_cast<size_t>(0), n, 0);
+        return;
+    }
+
+    size_t chunk_dim = n / nw;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(nw);
+
+    for (uint i = 0; i < nw; i++) {
+        size_t begin = i * chunk_dim;
+        size_t end = (i == nw - 1) ? n : begin + chunk_dim;
+        futures.push_back(pool.enqueue([&f, begin, end, i]() { f(begin, end, i); }, i));
+    }
+
+    for (auto &future : futures)
+        future.get();
+
+}
+
+#endif
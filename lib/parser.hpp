@@ -0,0 +1,333 @@
+#if !defined(__PARSER_H)
+#define __PARSER_H
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include "utils.hpp"
+#include "parallel.hpp"
+
+/**
+ * Hand-rolled scanner for whitespace separated edge lists
+ *
+ * The input buffer (usually a MappedFile) is split at line boundaries into one chunk per worker, and each worker
+ * parses its own chunk independently. Newlines are located with memchr, which the C library implements with
+ * vector instructions, while integers and floats are parsed by hand without locale or stream overhead.
+ */
+namespace parser {
+
+    // Approximate size of the blocks parsed at once by a worker
+    static const size_t PARSE_BLOCK_BYTES = 1 << 20;
+
+    // Exact powers of ten representable by a double
+    static const double POW10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool is_blank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == ',';
+    }
+
+    inline bool is_digit(char c) {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    /**
+     * @brief Skip blanks (spaces, tabs, carriage returns and commas) without crossing the end of the line
+     */
+    inline const char *skip_blanks(const char *p, const char *end) {
+        while (p < end && is_blank(*p))
+            p++;
+        return p;
+    }
+
+    /**
+     * @brief Return the first character of the line following p
+     */
+    inline const char *next_line(const char *p, const char *end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+        return nl == NULL ? end : nl + 1;
+    }
+
+    /**
+     * @brief Parse an unsigned integer
+     *
+     * @param p current position, advanced past the number on success
+     * @param end end of the buffer
+     * @param out the parsed value
+     * @return true if at least one digit has been read
+     */
+    inline bool parse_uint(const char *&p, const char *end, uint &out) {
+
+        const char *q = skip_blanks(p, end);
+
+        if (q == end || !is_digit(*q))
+            return false;
+
+        uint value = 0;
+
+        while (q < end && is_digit(*q)) {
+            value = value * 10 + (*q - '0');
+            q++;
+        }
+
+        out = value;
+        p = q;
+
+        return true;
+
+    }
+
+    /**
+     * @brief Parse an unsigned 64 bit integer (e.g. a timestamp), as parse_uint
+     */
+    inline bool parse_uint64(const char *&p, const char *end, uint64_t &out) {
+
+        const char *q = skip_blanks(p, end);
+
+        if (q == end || !is_digit(*q))
+            return false;
+
+        uint64_t value = 0;
+
+        while (q < end && is_digit(*q)) {
+            value = value * 10 + (*q - '0');
+            q++;
+        }
+
+        out = value;
+        p = q;
+
+        return true;
+
+    }
+
+    /**
+     * @brief Parse a decimal floating point number, with optional sign, fraction and exponent
+     *
+     * @param p current position, advanced past the number on success
+     * @param end end of the buffer
+     * @param out the parsed value
+     * @return true if at least one digit has been read
+     *
+     * Up to 19 significant digits are accumulated in a 64 bit integer, which is then scaled by the decimal exponent
+     * in double precision and rounded to float.
+     */
+    inline bool parse_float(const char *&p, const char *end, float &out) {
+
+        const char *q = skip_blanks(p, end);
+
+        bool negative = false;
+
+        if (q < end && (*q == '-' || *q == '+')) {
+            negative = (*q == '-');
+            q++;
+        }
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+
+        while (q < end && is_digit(*q)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*q - '0');
+                if (mantissa != 0) digits++;
+            }
+            else {
+                exponent++;
+            }
+            any = true;
+            q++;
+        }
+
+        if (q < end && *q == '.') {
+            q++;
+            while (q < end && is_digit(*q)) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (*q - '0');
+                    if (mantissa != 0) digits++;
+                    exponent--;
+                }
+                any = true;
+                q++;
+            }
+        }
+
+        if (!any)
+            return false;
+
+        if (q < end && (*q == 'e' || *q == 'E')) {
+
+            const char *r = q + 1;
+            bool negative_exp = false;
+
+            if (r < end && (*r == '-' || *r == '+')) {
+                negative_exp = (*r == '-');
+                r++;
+            }
+
+            if (r < end && is_digit(*r)) {
+                int e = 0;
+                while (r < end && is_digit(*r)) {
+                    if (e < 10000) e = e * 10 + (*r - '0');
+                    r++;
+                }
+                exponent += negative_exp ? -e : e;
+                q = r;
+            }
+
+        }
+
+        double value = static_cast<double>(mantissa);
+
+        if (exponent < 0)
+            value = exponent >= -22 ? value / POW10[-exponent] : value * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            value = exponent <= 22 ? value * POW10[exponent] : value * std::pow(10.0, exponent);
+
+        out = static_cast<float>(negative ? -value : value);
+        p = q;
+
+        return true;
+
+    }
+
+    /**
+     * @brief Split a buffer into nw chunks, each one starting at the beginning of a line
+     *
+     * @param data the buffer
+     * @param size size of the buffer
+     * @param nw number of chunks
+     * @return std::vector<size_t> the nw+1 offsets delimiting the chunks (some chunks may be empty)
+     */
+    inline std::vector<size_t> split_lines(const char *data, size_t size, uint nw) {
+
+        std::vector<size_t> bounds (nw + 1, size);
+
+        bounds[0] = 0;
+
+        for (uint i = 1; i < nw; i++) {
+
+            size_t guess = std::max(bounds[i-1], size / nw * i);
+
+            if (guess == 0 || guess >= size) {
+                bounds[i] = guess >= size ? size : 0;
+                continue;
+            }
+
+            // Move forward to the beginning of the next line, unless we are already there
+            if (data[guess - 1] == '\n')
+                bounds[i] = guess;
+            else
+                bounds[i] = next_line(data + guess, data + size) - data;
+
+        }
+
+        return bounds;
+
+    }
+
+    /**
+     * @brief Parse the edge lines in [begin, end)
+     *
+     * @param begin first character, must be the beginning of a line
+     * @param end one past the last character
+     * @param weighted whether each line carries a third, floating point, column
+     * @param out vector where the parsed edges are appended
+     *
+     * Lines that do not start with a number (comments, headers, empty lines) or that miss a column are skipped.
+     * Unweighted edges are given weight 0, the caller is expected to assign the real one.
+     */
+    inline void parse_edge_lines(const char *begin, const char *end, bool weighted, std::vector<MyEdge> &out) {
+
+        const char *p = begin;
+
+        while (p < end) {
+
+            const char *line_end = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (line_end == NULL) line_end = end;
+
+            uint a, b;
+            float c = 0;
+
+            const char *q = p;
+
+            if (parse_uint(q, line_end, a) && parse_uint(q, line_end, b) && (!weighted || parse_float(q, line_end, c)))
+                out.push_back({a, b, c});
+
+            p = line_end + 1;
+
+        }
+
+    }
+
+    /**
+     * @brief Split a buffer at line boundaries and let each worker parse its own chunk, block by block
+     *
+     * @param data the buffer
+     * @param size size of the buffer
+     * @param nw number of workers
+     * @param parse function called as parse(begin, end, out) on the block [begin, end), appending the edges to out
+     * @param block function called as block(index, edges) by worker index on the edges of each block, as soon as
+     *              the block has been parsed
+     *
+     * Blocks are about PARSE_BLOCK_BYTES long, so the edges handed to block are still in cache and the parsed
+     * edges never need to be stored all together.
+     */
+    template <typename ParseF, typename BlockF>
+    inline void stream_chunks(const char *data, size_t size, uint nw, ParseF parse, BlockF block) {
+
+        std::vector<size_t> bounds = split_lines(data, size, nw);
+
+        parallel_chunks(nw, nw, [&](size_t begin, size_t end, uint) {
+
+            std::vector<MyEdge> edges;
+
+            for (size_t i = begin; i < end; i++) {
+
+                const char *p = data + bounds[i];
+                const char *chunk_end = data + bounds[i+1];
+
+                while (p < chunk_end) {
+
+                    const char *block_end = static_cast<size_t>(chunk_end - p) <= PARSE_BLOCK_BYTES ? chunk_end : next_line(p + PARSE_BLOCK_BYTES, chunk_end);
+
+                    edges.clear();
+                    parse(p, block_end, edges);
+                    block(i, edges);
+
+                    p = block_end;
+
+                }
+
+            }
+
+        });
+
+    }
+
+    /**
+     * @brief Parse a whole edge list in parallel
+     *
+     * @param data the buffer
+     * @param size size of the buffer
+     * @param weighted whether each line carries a weight
+     * @param nw number of workers
+     * @param block function receiving the parsed blocks, see stream_chunks
+     */
+    template <typename BlockF>
+    inline void stream_edges(const char *data, size_t size, bool weighted, uint nw, BlockF block) {
+
+        stream_chunks(data, size, nw, [weighted](const char *begin, const char *end, std::vector<MyEdge> &out) {
+            parse_edge_lines(begin, end, weighted, out);
+        }, block);
+
+    }
+
+}
+
+#endif
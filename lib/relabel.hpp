@@ -0,0 +1,129 @@
+#if !defined(__RELABEL_H)
+#define __RELABEL_H
+
+#include <vector>
+#include <algorithm>
+#include "utils.hpp"
+#include "dset.hpp"
+
+/**
+ * @brief Dense renumbering of the components left by a Boruvka round
+ *
+ * After the contraction of a round the surviving nodes are the roots of the union-find. The k-th root in
+ * node order gets the new id k: every worker counts the roots of its range of nodes, the prefix sum of the
+ * counts gives the first id of each range, then every worker numbers the roots of its range. Edges are
+ * rewritten over the new ids while they are filtered, so the per-node arrays of the next round (minimum
+ * edges, union-find, node list) are sized to the contracted graph instead of the original one.
+ *
+ * The union-find is not modified between the contraction and the end of the filtering, so find() gives the
+ * final root of every node. A last pass flattens it: the new id of the component of every node is written
+ * into a plain array, and the edges are filtered with two loads from it instead of two find() walks on the
+ * shared atomic parents (whose path compression makes the threads write to the same cache lines).
+ *
+ * The components are given either as a DisjointSets or as a StarContraction (stars.hpp), through their
+ * parent() and find() methods.
+ */
+class Relabeling {
+
+    public:
+
+        // New id of each root, indexed by the node ids of the round (entries of the other nodes are meaningless)
+        std::vector<uint> label;
+
+        // New id of the component of each node, filled by flatten()
+        std::vector<uint> component;
+
+        /**
+         * @brief Prepare the renumbering of the nodes of a round
+         *
+         * @param numNodes size of the node id range of the round
+         * @param nw number of ranges the nodes are split into
+         */
+        void reset(uint numNodes, uint nw) {
+            label.resize(numNodes);
+            component.resize(numNodes);
+            first.assign(nw + 1, 0);
+        }
+
+        /**
+         * @brief First pass: count the roots among nodes[begin, end), range number index
+         */
+        template <typename ComponentsT>
+        void countRoots(const ComponentsT &components, ArrayRef<uint> nodes, uint begin, uint end, uint index) {
+
+            uint roots = 0;
+
+            for (uint i = begin; i < end; i++)
+                roots += components.parent(nodes[i]) == nodes[i];
+
+            first[index + 1] = roots;
+
+        }
+
+        /**
+         * @brief Turn the root counts of the ranges into the first new id of each range
+         */
+        void prefixSum() {
+            for (size_t i = 0; i + 1 < first.size(); i++)
+                first[i+1] += first[i];
+        }
+
+        /**
+         * @brief Second pass: number the roots among nodes[begin, end), range number index
+         */
+        template <typename ComponentsT>
+        void assignLabels(const ComponentsT &components, ArrayRef<uint> nodes, uint begin, uint end, uint index) {
+
+            uint id = first[index];
+
+            for (uint i = begin; i < end; i++)
+                if (components.parent(nodes[i]) == nodes[i])
+                    label[nodes[i]] = id++;
+
+        }
+
+        /**
+         * @brief Third pass, once all the roots are numbered: write the new id of the component of the nodes [begin, end)
+         */
+        template <typename ComponentsT>
+        void flatten(const ComponentsT &components, uint begin, uint end) {
+            for (uint node = begin; node < end; node++)
+                component[node] = componentOf(components, node);
+        }
+
+        // Number of components left, i.e. the size of the node id range of the next round
+        uint numLabels() const { return first.back(); }
+
+        // New id of the component of a node
+        template <typename ComponentsT>
+        uint componentOf(const ComponentsT &components, uint node) const {
+            return label[components.find(node)];
+        }
+
+        /**
+         * @brief Rewrite an edge over the new ids, canonical orientation from > to (after flatten)
+         *
+         * @return false if both endpoints are in the same component, and the edge is to be dropped
+         */
+        bool relabel(MyEdge &edge) const {
+
+            uint a = component[edge.from];
+            uint b = component[edge.to];
+
+            if (a == b)
+                return false;
+
+            edge = {std::max(a, b), std::min(a, b), edge.weight};
+
+            return true;
+
+        }
+
+    private:
+
+        // Roots of each range, then the first new id of each range
+        std::vector<uint> first;
+
+};
+
+#endif
@@ -0,0 +1,60 @@
+#if !defined(__RNG_H)
+#define __RNG_H
+
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * @brief SplitMix64 finalizer: a bijective mixing function over 64 bit integers
+ *
+ * From "Fast splittable pseudorandom number generators" by Steele, Lea and Flood
+ */
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+/**
+ * @brief Counter based random number generator
+ *
+ * The i-th number of a stream is a pure function of (seed, stream, i), so any worker can jump at any
+ * position of any stream without generating the previous numbers. Assigning to each worker a range of
+ * counters gives results that do not depend on the number of workers.
+ */
+class CounterRNG {
+
+    public:
+
+        /**
+         * @brief Construct a new generator
+         *
+         * @param seed the user provided seed
+         * @param stream identifier of the stream, different streams are independent
+         */
+        CounterRNG(uint64_t seed, uint64_t stream = 0) : key(splitmix64(splitmix64(seed) ^ (stream * 0xD1B54A32D192ED03ULL))) {}
+
+        // Random 64 bit value at the given position of the stream
+        uint64_t at(uint64_t counter) const {
+            return splitmix64(key ^ splitmix64(counter));
+        }
+
+        // Uniform double in [0, 1) at the given position of the stream
+        double uniform(uint64_t counter) const {
+            return (at(counter) >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        // Uniform integer in [0, n) at the given position of the stream (multiply-shift range reduction)
+        uint bounded(uint64_t counter, uint n) const {
+            return static_cast<uint>(((at(counter) >> 32) * static_cast<uint64_t>(n)) >> 32);
+        }
+
+    private:
+
+        uint64_t key;
+
+};
+
+#endif
@@ -0,0 +1,360 @@
+#if !defined(__SIMD_H)
+#define __SIMD_H
+
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include "utils.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+/**
+ * Vector kernels of the scan and filter phases
+ *
+ * Every kernel has a scalar version and, on x86, an AVX2 and an AVX-512 version compiled with the target
+ * attribute, so the binaries do not need any -m flag: the version is picked at run time with detect_simd()
+ * and only called on processors that support it. All versions give the same results.
+ */
+
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+
+/**
+ * @brief Best vector extension supported by the processor
+ */
+inline SimdLevel detect_simd() {
+
+#if defined(SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+#endif
+
+    return SimdLevel::SCALAR;
+
+}
+
+
+/**
+ * @brief Parse the name of a vector extension (auto, avx512, avx2, scalar)
+ *
+ * The result is capped to what the processor supports
+ */
+inline SimdLevel parse_simd(const std::string &name) {
+
+    SimdLevel supported = detect_simd();
+
+    SimdLevel requested = name == "scalar" ? SimdLevel::SCALAR : name == "avx2" ? SimdLevel::AVX2 : SimdLevel::AVX512;
+
+    return std::min(requested, supported);
+
+}
+
+
+inline const char *simd_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+
+/**
+ * @brief Filter and relabel a range of edges stored as a structure of arrays
+ *
+ * @param label id of the component of each node, looked up with gathers
+ * @param out_from, out_to, out_weight, out_id the surviving edges, with room for n edges (the vector versions
+ *        write whole vectors past the last surviving edge)
+ * @return size_t the number of surviving edges
+ *
+ * Edge i survives if its endpoints have different labels, and becomes (max label, min label, weight, id).
+ * Survivors keep their order.
+ */
+inline size_t filter_relabel_scalar(const uint *from, const uint *to, const float *weight, const uint *id, size_t n, const uint *label,
+                                    uint *out_from, uint *out_to, float *out_weight, uint *out_id) {
+
+    size_t kept = 0;
+
+    for (size_t i = 0; i < n; i++) {
+
+        uint a = label[from[i]];
+        uint b = label[to[i]];
+
+        if (a != b) {
+            out_from[kept] = std::max(a, b);
+            out_to[kept] = std::min(a, b);
+            out_weight[kept] = weight[i];
+            out_id[kept] = id[i];
+            kept++;
+        }
+
+    }
+
+    return kept;
+
+}
+
+
+/**
+ * @brief Minimum entry of a segment of weights, neighbours and edge ids
+ *
+ * @param best_weight, best_neighbour, best_id receive the lightest entry, the lowest id among equal weights
+ *        as in lighter() (MAX_WEIGHT and UINT32_MAX for an empty segment)
+ */
+inline void segment_min_scalar(const float *weight, const uint *neighbour, const uint *id, size_t n, float &best_weight, uint &best_neighbour, uint &best_id) {
+
+    best_weight = MAX_WEIGHT;
+    best_neighbour = UINT32_MAX;
+    best_id = UINT32_MAX;
+
+    for (size_t i = 0; i < n; i++) {
+        if (weight[i] < best_weight || (weight[i] == best_weight && id[i] < best_id)) {
+            best_weight = weight[i];
+            best_neighbour = neighbour[i];
+            best_id = id[i];
+        }
+    }
+
+}
+
+
+#if defined(SIMD_X86)
+
+/**
+ * @brief Permutations of the AVX2 compress: entry m moves the lanes set in the 8 bit mask m to the front
+ */
+inline const uint32_t *compress_permutations() {
+
+    static const struct Table {
+        alignas(32) uint32_t lanes[256][8];
+        Table() {
+            for (uint mask = 0; mask < 256; mask++) {
+                uint k = 0;
+                for (uint lane = 0; lane < 8; lane++)
+                    if (mask & (1u << lane))
+                        lanes[mask][k++] = lane;
+                while (k < 8)
+                    lanes[mask][k++] = 0;
+            }
+        }
+    } table;
+
+    return &table.lanes[0][0];
+
+}
+
+
+__attribute__((target("avx2")))
+inline size_t filter_relabel_avx2(const uint *from, const uint *to, const float *weight, const uint *id, size_t n, const uint *label,
+                                  uint *out_from, uint *out_to, float *out_weight, uint *out_id) {
+
+    const uint32_t *permutations = compress_permutations();
+    const int *table = reinterpret_cast<const int *>(label);
+
+    size_t kept = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+
+        __m256i a = _mm256_i32gather_epi32(table, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(from + i)), 4);
+        __m256i b = _mm256_i32gather_epi32(table, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(to + i)), 4);
+
+        uint mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))) & 0xFF;
+
+        __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(permutations + 8 * mask));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out_from + kept), _mm256_permutevar8x32_epi32(_mm256_max_epu32(a, b), permutation));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out_to + kept), _mm256_permutevar8x32_epi32(_mm256_min_epu32(a, b), permutation));
+        _mm256_storeu_ps(out_weight + kept, _mm256_permutevar8x32_ps(_mm256_loadu_ps(weight + i), permutation));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out_id + kept),
+                            _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(id + i)), permutation));
+
+        kept += __builtin_popcount(mask);
+
+    }
+
+    return kept + filter_relabel_scalar(from + i, to + i, weight + i, id + i, n - i, label, out_from + kept, out_to + kept, out_weight + kept, out_id + kept);
+
+}
+
+
+__attribute__((target("avx512f")))
+inline size_t filter_relabel_avx512(const uint *from, const uint *to, const float *weight, const uint *id, size_t n, const uint *label,
+                                    uint *out_from, uint *out_to, float *out_weight, uint *out_id) {
+
+    size_t kept = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+
+        // The masked forms start from a zeroed vector, the plain ones start from an undefined one
+        __m512i a = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, _mm512_loadu_si512(from + i), label, 4);
+        __m512i b = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, _mm512_loadu_si512(to + i), label, 4);
+
+        __mmask16 keep = _mm512_cmpneq_epi32_mask(a, b);
+
+        _mm512_mask_compressstoreu_epi32(out_from + kept, keep, _mm512_maskz_max_epu32(keep, a, b));
+        _mm512_mask_compressstoreu_epi32(out_to + kept, keep, _mm512_maskz_min_epu32(keep, a, b));
+        _mm512_mask_compressstoreu_ps(out_weight + kept, keep, _mm512_loadu_ps(weight + i));
+        _mm512_mask_compressstoreu_epi32(out_id + kept, keep, _mm512_loadu_si512(id + i));
+
+        kept += __builtin_popcount(keep);
+
+    }
+
+    return kept + filter_relabel_scalar(from + i, to + i, weight + i, id + i, n - i, label, out_from + kept, out_to + kept, out_weight + kept, out_id + kept);
+
+}
+
+
+__attribute__((target("avx2")))
+inline void segment_min_avx2(const float *weight, const uint *neighbour, const uint *id, size_t n, float &best_weight, uint &best_neighbour, uint &best_id) {
+
+    if (n < 8) {
+        segment_min_scalar(weight, neighbour, id, n, best_weight, best_neighbour, best_id);
+        return;
+    }
+
+    // AVX2 only compares signed integers: flipping the sign bit keeps the unsigned order
+    const __m256i sign = _mm256_set1_epi32(0x80000000);
+
+    __m256 lane_weight = _mm256_set1_ps(MAX_WEIGHT);
+    __m256i lane_neighbour = _mm256_set1_epi32(-1);
+    __m256i lane_id = _mm256_set1_epi32(-1);
+
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+
+        __m256 w = _mm256_loadu_ps(weight + i);
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(neighbour + i));
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(id + i));
+
+        __m256 lower = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_xor_si256(lane_id, sign), _mm256_xor_si256(e, sign)));
+        __m256 better = _mm256_or_ps(_mm256_cmp_ps(w, lane_weight, _CMP_LT_OQ), _mm256_and_ps(_mm256_cmp_ps(w, lane_weight, _CMP_EQ_OQ), lower));
+
+        lane_weight = _mm256_blendv_ps(lane_weight, w, better);
+        lane_neighbour = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(lane_neighbour), _mm256_castsi256_ps(v), better));
+        lane_id = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(lane_id), _mm256_castsi256_ps(e), better));
+
+    }
+
+    alignas(32) float weights[8];
+    alignas(32) uint neighbours[8];
+    alignas(32) uint ids[8];
+
+    _mm256_store_ps(weights, lane_weight);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(neighbours), lane_neighbour);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(ids), lane_id);
+
+    // Lanes and remainder
+    segment_min_scalar(weight + i, neighbour + i, id + i, n - i, best_weight, best_neighbour, best_id);
+
+    for (uint lane = 0; lane < 8; lane++) {
+        if (weights[lane] < best_weight || (weights[lane] == best_weight && ids[lane] < best_id)) {
+            best_weight = weights[lane];
+            best_neighbour = neighbours[lane];
+            best_id = ids[lane];
+        }
+    }
+
+}
+
+
+__attribute__((target("avx512f")))
+inline void segment_min_avx512(const float *weight, const uint *neighbour, const uint *id, size_t n, float &best_weight, uint &best_neighbour, uint &best_id) {
+
+    if (n < 16) {
+        segment_min_scalar(weight, neighbour, id, n, best_weight, best_neighbour, best_id);
+        return;
+    }
+
+    __m512 lane_weight = _mm512_set1_ps(MAX_WEIGHT);
+    __m512i lane_neighbour = _mm512_set1_epi32(-1);
+    __m512i lane_id = _mm512_set1_epi32(-1);
+
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+
+        __m512 w = _mm512_loadu_ps(weight + i);
+        __m512i v = _mm512_loadu_si512(neighbour + i);
+        __m512i e = _mm512_loadu_si512(id + i);
+
+        __mmask16 better = _mm512_cmp_ps_mask(w, lane_weight, _CMP_LT_OQ)
+            | (_mm512_cmp_ps_mask(w, lane_weight, _CMP_EQ_OQ) & _mm512_cmplt_epu32_mask(e, lane_id));
+
+        lane_weight = _mm512_mask_blend_ps(better, lane_weight, w);
+        lane_neighbour = _mm512_mask_blend_epi32(better, lane_neighbour, v);
+        lane_id = _mm512_mask_blend_epi32(better, lane_id, e);
+
+    }
+
+    alignas(64) float weights[16];
+    alignas(64) uint neighbours[16];
+    alignas(64) uint ids[16];
+
+    _mm512_store_ps(weights, lane_weight);
+    _mm512_store_si512(neighbours, lane_neighbour);
+    _mm512_store_si512(ids, lane_id);
+
+    // Lanes and remainder
+    segment_min_scalar(weight + i, neighbour + i, id + i, n - i, best_weight, best_neighbour, best_id);
+
+    for (uint lane = 0; lane < 16; lane++) {
+        if (weights[lane] < best_weight || (weights[lane] == best_weight && ids[lane] < best_id)) {
+            best_weight = weights[lane];
+            best_neighbour = neighbours[lane];
+            best_id = ids[lane];
+        }
+    }
+
+}
+
+#endif
+
+
+/**
+ * @brief Filter and relabel a range of edges with the given vector extension (see filter_relabel_scalar)
+ *
+ * Gathers take signed 32 bit indexes: node ids must be below 2^31
+ */
+inline size_t filter_relabel(SimdLevel level, const uint *from, const uint *to, const float *weight, const uint *id, size_t n, const uint *label,
+                             uint *out_from, uint *out_to, float *out_weight, uint *out_id) {
+
+#if defined(SIMD_X86)
+    if (level == SimdLevel::AVX512)
+        return filter_relabel_avx512(from, to, weight, id, n, label, out_from, out_to, out_weight, out_id);
+    if (level == SimdLevel::AVX2)
+        return filter_relabel_avx2(from, to, weight, id, n, label, out_from, out_to, out_weight, out_id);
+#endif
+
+    return filter_relabel_scalar(from, to, weight, id, n, label, out_from, out_to, out_weight, out_id);
+
+}
+
+
+/**
+ * @brief Minimum entry of a segment with the given vector extension (see segment_min_scalar)
+ */
+inline void segment_min(SimdLevel level, const float *weight, const uint *neighbour, const uint *id, size_t n, float &best_weight, uint &best_neighbour, uint &best_id) {
+
+#if defined(SIMD_X86)
+    if (level == SimdLevel::AVX512)
+        return segment_min_avx512(weight, neighbour, id, n, best_weight, best_neighbour, best_id);
+    if (level == SimdLevel::AVX2)
+        return segment_min_avx2(weight, neighbour, id, n, best_weight, best_neighbour, best_id);
+#endif
+
+    segment_min_scalar(weight, neighbour, id, n, best_weight, best_neighbour, best_id);
+
+}
+
+#endif
@@ -0,0 +1,170 @@
+#if !defined(__SNAPSHOT_H)
+#define __SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "utils.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * Binary graph snapshot
+ *
+ * Layout of the file, all fields in native byte order:
+ *
+ *  - SnapshotHeader (64 bytes)
+ *  - node table: numNodes uint32 values, padded to a multiple of 8 bytes
+ *  - edge table: numEdges packed MyEdge records, one per undirected edge (from > to); the id of an edge is its position
+ *
+ * The file is meant to be written once with write_snapshot and then mapped read-only by Snapshot,
+ * so that loading a graph costs a single sequential read of the tables.
+ */
+
+#define SNAPSHOT_MAGIC "BORUVKA"
+#define SNAPSHOT_VERSION 2
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t edgeSize;
+    uint64_t numNodes;
+    uint64_t numEdges;
+    uint64_t originalNodes;
+    uint64_t nodesOffset;
+    uint64_t edgesOffset;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "unexpected snapshot header size");
+
+
+/**
+ * @brief Check whether the given file starts with the snapshot magic string
+ */
+inline bool is_snapshot(const std::string &filename) {
+
+    FILE *file = fopen(filename.c_str(), "rb");
+
+    if (file == NULL)
+        return false;
+
+    char magic[8] = {0};
+    size_t read = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    return read == sizeof(magic) && memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+
+}
+
+
+/**
+ * @brief Write a snapshot of the given node and edge tables
+ *
+ * @param filename destination file, overwritten if it exists
+ * @param nodes the node table
+ * @param edges the edge table
+ * @param originalNodes number of nodes of the original graph
+ */
+inline void write_snapshot(const std::string &filename, ArrayRef<uint> nodes, ArrayRef<MyEdge> edges, uint originalNodes) {
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    header.version = SNAPSHOT_VERSION;
+    header.edgeSize = sizeof(MyEdge);
+    header.numNodes = nodes.size();
+    header.numEdges = edges.size();
+    header.originalNodes = originalNodes;
+    header.nodesOffset = sizeof(SnapshotHeader);
+    header.edgesOffset = header.nodesOffset + ((nodes.size() * sizeof(uint) + 7) & ~static_cast<uint64_t>(7));
+
+    FILE *file = fopen(filename.c_str(), "wb");
+
+    if (file == NULL)
+        throw std::runtime_error("cannot create " + filename);
+
+    const uint64_t padding = 0;
+    size_t node_bytes = nodes.size() * sizeof(uint);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(nodes.data(), 1, node_bytes, file) == node_bytes
+        && fwrite(&padding, 1, header.edgesOffset - header.nodesOffset - node_bytes, file) == header.edgesOffset - header.nodesOffset - node_bytes
+        && fwrite(edges.data(), sizeof(MyEdge), edges.size(), file) == edges.size();
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+        throw std::runtime_error("cannot write " + filename);
+
+}
+
+
+/**
+ * @brief Read-only view over a snapshot file
+ *
+ * The file is memory mapped and validated at construction, node and edge tables are then
+ * accessed in place without any parsing.
+ */
+class Snapshot {
+
+    public:
+
+        Snapshot(const std::string &filename) : file(filename) {
+
+            if (file.size() < sizeof(SnapshotHeader))
+                throw std::runtime_error(filename + " is not a graph snapshot");
+
+            header = reinterpret_cast<const SnapshotHeader *>(file.data());
+
+            if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+                throw std::runtime_error(filename + " is not a graph snapshot");
+
+            if (header->version != SNAPSHOT_VERSION || header->edgeSize != sizeof(MyEdge))
+                throw std::runtime_error(filename + ": unsupported snapshot version " + std::to_string(header->version));
+
+            // The counts are bounded by the bytes left before they are multiplied, so that a corrupted header cannot
+            // wrap the products around and pass the checks
+            uint64_t size = file.size();
+
+            if (header->nodesOffset < sizeof(SnapshotHeader) || header->nodesOffset > size
+                || header->numNodes > (size - header->nodesOffset) / sizeof(uint)
+                || header->edgesOffset < header->nodesOffset + header->numNodes * sizeof(uint) || header->edgesOffset > size
+                || header->numEdges > (size - header->edgesOffset) / sizeof(MyEdge))
+                throw std::runtime_error(filename + ": truncated snapshot");
+
+            // The tables are read in place, the mapping itself starts on a page boundary
+            if (header->nodesOffset % alignof(uint) != 0 || header->edgesOffset % alignof(MyEdge) != 0)
+                throw std::runtime_error(filename + ": misaligned snapshot tables");
+
+        }
+
+        uint64_t numNodes() const { return header->numNodes; }
+
+        uint64_t numEdges() const { return header->numEdges; }
+
+        uint originalNodes() const { return static_cast<uint>(header->originalNodes); }
+
+        // Byte offset of the edge table in the file
+        uint64_t edgesOffset() const { return header->edgesOffset; }
+
+        const uint *nodes() const {
+            return reinterpret_cast<const uint *>(file.data() + header->nodesOffset);
+        }
+
+        const MyEdge *edges() const {
+            return reinterpret_cast<const MyEdge *>(file.data() + header->edgesOffset);
+        }
+
+    private:
+
+        MappedFile file;
+
+        const SnapshotHeader *header;
+
+};
+
+#endif
@@ -0,0 +1,76 @@
+#if !defined(__SOA_H)
+#define __SOA_H
+
+#include <vector>
+#include "utils.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief Edge list stored as a structure of arrays
+ *
+ * The starting nodes, the ending nodes, the weights and the ids are kept in separate arrays, so that a phase
+ * only reads the fields it needs (the ids are only read for the minimum edges and the survivors of the filters) and the vector kernels of simd.hpp can load consecutive fields of 8 or
+ * 16 edges with a single instruction.
+ */
+class EdgeArrays {
+
+    public:
+
+        std::vector<uint> from;
+
+        std::vector<uint> to;
+
+        std::vector<float> weight;
+
+        std::vector<uint> id;
+
+        EdgeArrays() {}
+
+        /**
+         * @brief Split a list of edges into the arrays
+         *
+         * @param edges the loaded edges, whose ids are their positions
+         * @param nw number of workers
+         */
+        EdgeArrays(ArrayRef<MyEdge> edges, uint nw) {
+
+            resize(edges.size());
+
+            parallel_chunks(edges.size(), nw, [&](size_t begin, size_t end, uint) {
+                for (size_t i = begin; i < end; i++) {
+                    from[i] = edges[i].from;
+                    to[i] = edges[i].to;
+                    weight[i] = edges[i].weight;
+                    id[i] = static_cast<uint>(i);
+                }
+            });
+
+        }
+
+        size_t size() const { return weight.size(); }
+
+        void resize(size_t n) {
+            from.resize(n);
+            to.resize(n);
+            weight.resize(n);
+            id.resize(n);
+        }
+
+        // Edge number i, put back together
+        MyEdge operator[](size_t i) const {
+            return {from[i], to[i], weight[i]};
+        }
+
+        /**
+         * @brief Append the edges of another list
+         */
+        void append(const EdgeArrays &other) {
+            from.insert(from.end(), other.from.begin(), other.from.end());
+            to.insert(to.end(), other.to.begin(), other.to.end());
+            weight.insert(weight.end(), other.weight.begin(), other.weight.end());
+            id.insert(id.end(), other.id.begin(), other.id.end());
+        }
+
+};
+
+#endif
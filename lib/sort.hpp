@@ -0,0 +1,234 @@
+#if !defined(__SORT_H)
+#define __SORT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "utils.hpp"
+#include "parallel.hpp"
+
+/**
+ * @brief Sorting key of an edge: the (from, to) pair packed into 64 bits
+ */
+inline uint64_t edge_key(const MyEdge &edge) {
+    return (static_cast<uint64_t>(edge.from) << 32) | edge.to;
+}
+
+
+/**
+ * @brief Sorting key of a weight: the float bits mapped to an unsigned integer with the same order
+ */
+inline uint32_t weight_key(float weight) {
+    uint32_t bits;
+    memcpy(&bits, &weight, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+
+/**
+ * @brief Stable parallel LSD radix sort of an array, with a buffer of the caller
+ *
+ * @tparam T type of the elements
+ * @tparam KeyF function type returning the uint64_t key of an element
+ * @param data the n elements to sort
+ * @param buffer room for n elements, overwritten
+ * @param n number of elements
+ * @param key the key function
+ * @param key_bits number of significant bits of the keys
+ * @param nw number of workers
+ * @return true if the sorted elements ended up in buffer rather than in data
+ *
+ * Keys are sorted 8 bits at a time. For each pass every worker computes the histogram of its own chunk,
+ * the histograms are turned into per-worker output offsets and every worker scatters its chunk into the
+ * other array. Passes in which every key has the same digit are skipped.
+ * Elements with the same key keep their original relative order.
+ */
+template <typename T, typename KeyF>
+bool parallel_radix_sort(T *data, T *buffer, size_t n, KeyF key, int key_bits, uint nw) {
+
+    if (n < 2)
+        return false;
+
+    if (n < 4096)
+        nw = 1;
+
+    T *source = data;
+    T *target = buffer;
+
+    // Histograms of the current digit, one per worker
+    std::vector<std::vector<size_t>> counts (nw, std::vector<size_t>(256));
+
+    for (int shift = 0; shift < key_bits; shift += 8) {
+
+        parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+            std::vector<size_t> &count = counts[thid];
+            std::fill(count.begin(), count.end(), 0);
+            for (size_t i = begin; i < end; i++)
+                count[(key(source[i]) >> shift) & 0xFF]++;
+        });
+
+        // Skip the pass if all the keys fall into the same bucket
+        bool trivial = false;
+
+        for (uint d = 0; d < 256 && !trivial; d++) {
+            size_t total = 0;
+            for (uint w = 0; w < nw; w++)
+                total += counts[w][d];
+            trivial = (total == n);
+        }
+
+        if (trivial)
+            continue;
+
+        // Turn histograms into starting offsets: digit-major, then worker order for stability
+        size_t offset = 0;
+
+        for (uint d = 0; d < 256; d++) {
+            for (uint w = 0; w < nw; w++) {
+                size_t count = counts[w][d];
+                counts[w][d] = offset;
+                offset += count;
+            }
+        }
+
+        parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+            std::vector<size_t> &position = counts[thid];
+            for (size_t i = begin; i < end; i++)
+                target[position[(key(source[i]) >> shift) & 0xFF]++] = source[i];
+        });
+
+        std::swap(source, target);
+
+    }
+
+    return source == buffer;
+
+}
+
+
+/**
+ * @brief Stable parallel LSD radix sort of a vector, see above
+ *
+ * @tparam AllocT allocator of the vector, also used by the temporary buffer
+ */
+template <typename T, typename AllocT, typename KeyF>
+void parallel_radix_sort(std::vector<T, AllocT> &data, KeyF key, int key_bits, uint nw) {
+
+    if (data.size() < 2)
+        return;
+
+    std::vector<T, AllocT> buffer (data.size());
+
+    if (parallel_radix_sort(data.data(), buffer.data(), data.size(), key, key_bits, nw))
+        data.swap(buffer);
+
+}
+
+
+/**
+ * @brief Parallel stable compaction of a vector
+ *
+ * @tparam T type of the elements
+ * @tparam AllocT allocator of the vector, also used by the compacted copy
+ * @tparam KeepF function type, called as keep(i) on the indexes of data
+ * @param data the vector to compact in place
+ * @param keep the predicate telling whether element i survives
+ * @param nw number of workers
+ *
+ * Every worker first counts the survivors of its chunk, then copies them at the offset given by the prefix
+ * sum of the counts. The predicate is evaluated on the original contents, so it may look at neighbouring elements.
+ */
+template <typename T, typename AllocT, typename KeepF>
+void parallel_compact(std::vector<T, AllocT> &data, KeepF keep, uint nw) {
+
+    const size_t n = data.size();
+
+    if (n < 4096)
+        nw = 1;
+
+    std::vector<size_t> offsets (nw + 1, 0);
+
+    parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++)
+            if (keep(i)) count++;
+        offsets[thid + 1] = count;
+    });
+
+    for (uint w = 0; w < nw; w++)
+        offsets[w + 1] += offsets[w];
+
+    std::vector<T, AllocT> compacted (offsets[nw]);
+
+    parallel_chunks(n, nw, [&](size_t begin, size_t end, uint thid) {
+        size_t position = offsets[thid];
+        for (size_t i = begin; i < end; i++)
+            if (keep(i)) compacted[position++] = data[i];
+    });
+
+    data.swap(compacted);
+
+}
+
+
+/**
+ * @brief Sort edges by (from, to) and drop duplicates, keeping the lightest copy of each pair
+ *
+ * @param edges the edges to sort
+ * @param nw number of workers
+ *
+ * Parallel edges never belong to a minimum spanning tree unless they are the lightest, so only that one is
+ * kept (the first one in the input among copies with the same weight). The result does not depend on the
+ * order of the input.
+ */
+inline void sort_unique_edges(std::vector<MyEdge> &edges, uint nw) {
+
+    uint max_node = 0;
+    for (auto &edge : edges)
+        max_node = std::max(max_node, std::max(edge.from, edge.to));
+
+    int node_bits = 0;
+    while (node_bits < 32 && (max_node >> node_bits) != 0)
+        node_bits++;
+
+    // Only the bits actually used by the node ids are sorted
+    parallel_radix_sort(edges, [node_bits](const MyEdge &edge) {
+        return (static_cast<uint64_t>(edge.from) << node_bits) | edge.to;
+    }, 2 * node_bits, nw);
+
+    // The first copy of each pair takes the lightest weight of its run, the run may extend past the chunk
+    parallel_chunks(edges.size(), nw, [&edges](size_t begin, size_t end, uint) {
+        for (size_t i = begin; i < end; i++) {
+            if (i != 0 && edges[i] == edges[i-1])
+                continue;
+            for (size_t j = i + 1; j < edges.size() && edges[j] == edges[i]; j++)
+                if (edges[j].weight < edges[i].weight)
+                    edges[i].weight = edges[j].weight;
+        }
+    });
+
+    parallel_compact(edges, [&edges](size_t i) {
+        return i == 0 || !(edges[i] == edges[i-1]);
+    }, nw);
+
+}
+
+
+/**
+ * @brief Sort node ids and drop duplicates
+ *
+ * @param nodes the node ids to sort
+ * @param nw number of workers
+ */
+inline void sort_unique_nodes(std::vector<uint> &nodes, uint nw) {
+
+    parallel_radix_sort(nodes, [](uint node) { return static_cast<uint64_t>(node); }, 32, nw);
+
+    parallel_compact(nodes, [&nodes](size_t i) {
+        return i == 0 || nodes[i] != nodes[i-1];
+    }, nw);
+
+}
+
+#endif
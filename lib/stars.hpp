@@ -0,0 +1,126 @@
+#if !defined(__STARS_H)
+#define __STARS_H
+
+#include <vector>
+#include "utils.hpp"
+
+/**
+ * @brief Contraction of a Boruvka round by hooking and pointer jumping, as an alternative to the union-find
+ *
+ * Every node hooks to the other endpoint of its minimum edge. Since the minimum edges are chosen with a
+ * total order, the only cycles of the resulting pseudo-forest are the 2-cycles of the nodes picking the
+ * same edge: the lower id of the two becomes the root. Then every node jumps to the parent of its parent
+ * until all the trees are stars, i.e. until every node points to its root.
+ *
+ * Every step reads one array and writes another one, so the threads never write to the same entries and
+ * the result does not depend on their interleaving: the cost of a round is a hooking pass, a cycle
+ * breaking pass and one pass per jump (logarithmic in the depth of the trees).
+ *
+ * The nodes that are not roots once the cycles are broken hook along the edges added to the spanning tree.
+ *
+ * Once contracted it exposes the parent() and find() of DisjointSets, so it can be relabeled the same way.
+ */
+class StarContraction {
+
+    public:
+
+        /**
+         * @brief Prepare the contraction of the node ids [0, n)
+         */
+        void reset(uint n) {
+            parents.resize(n);
+            next.resize(n);
+            hooks.resize(n);
+        }
+
+        /**
+         * @brief Hook the nodes [begin, end) to the other endpoint of their minimum edge
+         *
+         * @param minEdge function giving the minimum edge of a node, {0, 0, MAX_WEIGHT} if it has none
+         */
+        template <typename MinEdgeF>
+        void hook(uint begin, uint end, MinEdgeF minEdge) {
+
+            MyEdge NULL_CONN = {0, 0, MAX_WEIGHT};
+
+            for (uint node = begin; node < end; node++) {
+
+                IdEdge edge = minEdge(node);
+
+                parents[node] = edge == NULL_CONN ? node : edge.from == node ? edge.to : edge.from;
+
+                hooks[node] = edge.id;
+
+            }
+
+        }
+
+        /**
+         * @brief Make the lower id of each 2-cycle among the nodes [begin, end) a root, into the other array
+         *
+         * @param record function called as record(id) with the id of the edge of every node still hooked, i.e.
+         *        once per edge of the spanning tree
+         */
+        template <typename RecordF>
+        void breakCycles(uint begin, uint end, RecordF record) {
+
+            for (uint node = begin; node < end; node++) {
+
+                uint parent = parents[node];
+
+                next[node] = parents[parent] == node && node < parent ? node : parent;
+
+                if (next[node] != node)
+                    record(hooks[node]);
+
+            }
+
+        }
+
+        /**
+         * @brief Move the nodes [begin, end) to the parent of their parent, into the other array
+         *
+         * @return true if any of them moved
+         */
+        bool jump(uint begin, uint end) {
+
+            bool moved = false;
+
+            for (uint node = begin; node < end; node++) {
+
+                next[node] = parents[parents[node]];
+
+                moved |= next[node] != parents[node];
+
+            }
+
+            return moved;
+
+        }
+
+        /**
+         * @brief Make the array written by the last pass the current one, once all the threads are done with it
+         */
+        void swap() {
+            parents.swap(next);
+        }
+
+        uint parent(uint node) const { return parents[node]; }
+
+        // Once all the trees are stars the parent is the root
+        uint find(uint node) const { return parents[node]; }
+
+    private:
+
+        // Current parent of each node
+        std::vector<uint> parents;
+
+        // Parents written by the pass in progress
+        std::vector<uint> next;
+
+        // Id of the edge each node hooked along
+        std::vector<uint> hooks;
+
+};
+
+#endif
@@ -0,0 +1,272 @@
+#if !defined(__STREAM_H)
+#define __STREAM_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <stdexcept>
+#include "utils.hpp"
+#include "mapped_file.hpp"
+#include "parser.hpp"
+#include "formats.hpp"
+#include "rng.hpp"
+#include "mst.hpp"
+#include "incremental.hpp"
+
+/**
+ * @brief Sequential reader of a timestamped edge stream
+ *
+ * Whitespace separated "from to weight time" lines, or "from to time" lines for unweighted streams (e.g. the
+ * SNAP temporal networks), with 0-based ids and integer timestamps. The number of columns is taken from the
+ * first data line, lines that do not start with a number are skipped. Weights are handled as in
+ * Graph::loadGraph: unweighted edges get a random weight in [0, 10), weighted ones a random perturbation in
+ * [-1, 1) only with jitter, both depending on the seed and the pair of nodes.
+ *
+ * Edges are expected by increasing time, an edge older than the previous ones joins the slide being read.
+ */
+class EdgeStream {
+
+    public:
+
+        EdgeStream(const std::string &filename, uint64_t seed = 1, bool jitter = false) :
+            file(filename), weight_stream(seed, 40) {
+
+            p = file.data();
+            end = file.data() + file.size();
+
+            int columns = formats::count_columns(formats::first_data_line(p, end), end);
+
+            if (columns < 3)
+                throw std::runtime_error(filename + " is not an edge stream (from to [weight] time lines)");
+
+            weighted = columns >= 4;
+
+            perturbed = jitter || !weighted;
+
+            advance();
+
+        }
+
+        // Whether all the edges have been read
+        bool done() const { return !pending; }
+
+        // Time of the next edge
+        uint64_t nextTime() const { return next_time; }
+
+        /**
+         * @brief Append the edges arriving before the given time to batch, in stream order
+         *
+         * @return size_t the number of edges appended
+         */
+        size_t read(uint64_t until, std::vector<MyEdge> &batch) {
+
+            size_t n = 0;
+
+            while (pending && next_time < until) {
+                batch.push_back(next_edge);
+                n++;
+                advance();
+            }
+
+            return n;
+
+        }
+
+    private:
+
+        MappedFile file;
+
+        const char *p;
+
+        const char *end;
+
+        const CounterRNG weight_stream;
+
+        bool weighted;
+
+        bool perturbed;
+
+        bool pending = false;
+
+        MyEdge next_edge;
+
+        uint64_t next_time = 0;
+
+        // Parse the next edge into next_edge
+        void advance() {
+
+            pending = false;
+
+            while (!pending && p < end) {
+
+                const char *line_end = parser::next_line(p, end);
+
+                const char *q = p;
+
+                uint a, b;
+                float weight = 0;
+                uint64_t time;
+
+                if (parser::parse_uint(q, line_end, a) && parser::parse_uint(q, line_end, b)
+                    && (!weighted || parser::parse_float(q, line_end, weight)) && parser::parse_uint64(q, line_end, time)) {
+
+                    uint high = std::max(a, b);
+                    uint low = std::min(a, b);
+
+                    if (perturbed)
+                        weight += (weighted ? -1 : 0) + (weighted ? 2 : 10) * weight_stream.uniform((static_cast<uint64_t>(high) << 32) | low);
+
+                    next_edge = {high, low, weight};
+                    next_time = std::max(next_time, time);
+                    pending = true;
+
+                }
+
+                p = line_end;
+
+            }
+
+        }
+
+};
+
+
+/**
+ * @brief Minimum spanning forest of a sliding window over an edge stream
+ *
+ * The window is made of the last `slides` slides of the stream. The forest of a union of edge sets is the
+ * forest of the union of their forests, an associative combination, so the window is aggregated as a queue
+ * made of two stacks:
+ * - the newer slides of the window, with the forest of each one and the forest of all of them;
+ * - the older slides, with the forest of each suffix of them: from each slide to the newest of the older ones.
+ * A slide entering the window is added to the forest of the newer slides. A slide leaving it drops the oldest
+ * suffix forest; when there are no older slides left, the newer ones become the older ones and their suffix
+ * forests are built from the newest to the oldest, one combination per slide. The forest of the window is
+ * the combination of the oldest suffix forest with the forest of the newer slides.
+ *
+ * Every combination is an insertion into a forest (see IncrementalMST), in O(n + b) per round for n nodes
+ * and b edges per slide, and a slide takes three of them in amortized terms, instead of a run over the whole
+ * window of slides * b edges. An edge only survives in the aggregates while no lighter path of edges at least
+ * as recent closes a cycle with it.
+ */
+class WindowedMST {
+
+    public:
+
+        /**
+         * @param slides number of slides of the window
+         * @param nw number of workers of the insertions
+         */
+        WindowedMST(uint slides, uint nw) : slides(std::max<uint>(slides, 1)), engine(nw) {}
+
+        /**
+         * @brief Add the edges of the next slide to the window, the oldest slide leaves it if it is full
+         */
+        void slide(const std::vector<MyEdge> &batch) {
+
+            MST slide_forest;
+
+            engine.insert(slide_forest, batch);
+
+            engine.insert(newer, slide_forest.edges);
+
+            newer_slides.push_back(std::move(slide_forest));
+
+            sizes.push_back(batch.size());
+
+            if (sizes.size() > slides) {
+
+                if (older.empty()) {
+
+                    // The newer slides become the older ones, with the forest of each suffix of them
+                    older.resize(newer_slides.size());
+
+                    older.back() = std::move(newer_slides.back());
+
+                    for (size_t i = newer_slides.size() - 1; i-- > 0; ) {
+                        older[i] = older[i+1];
+                        engine.insert(older[i], newer_slides[i].edges);
+                    }
+
+                    newer_slides.clear();
+                    newer = MST();
+
+                }
+
+                older.pop_front();
+                sizes.pop_front();
+
+            }
+
+            if (older.empty())
+                window = newer;
+            else {
+                window = older.front();
+                if (!newer_slides.empty())
+                    engine.insert(window, newer.edges);
+            }
+
+        }
+
+        // Number of edges of the window, copies and self loops included
+        size_t windowEdges() const {
+            size_t n = 0;
+            for (size_t size : sizes)
+                n += size;
+            return n;
+        }
+
+        /**
+         * @brief Forest of the window, with its trees over the nodes of the window having some edge
+         */
+        MST forest() const {
+
+            MST mst = window;
+
+            uint numNodes = 0;
+
+            for (auto &edge : mst.edges)
+                numNodes = std::max(numNodes, edge.from + 1);
+
+            std::vector<char> endpoint (numNodes, 0);
+
+            for (auto &edge : mst.edges)
+                endpoint[edge.from] = endpoint[edge.to] = 1;
+
+            std::vector<uint> nodes;
+
+            for (uint node = 0; node < numNodes; node++)
+                if (endpoint[node])
+                    nodes.push_back(node);
+
+            mst.findTrees(nodes, numNodes);
+
+            return mst;
+
+        }
+
+    private:
+
+        uint slides;
+
+        // Every insertion of the slides runs on the same threads and buffers
+        IncrementalMST engine;
+
+        // Forest of each of the newer slides, and of all of them
+        std::vector<MST> newer_slides;
+
+        MST newer;
+
+        // Forest of the older slides from each one to the newest of them, oldest first
+        std::deque<MST> older;
+
+        // Forest of the window
+        MST window;
+
+        // Number of edges of each slide of the window, oldest first
+        std::deque<size_t> sizes;
+
+};
+
+#endif
@@ -25,8 +25,8 @@ class ThreadPool final {
             m_mu(nthreads),
             m_cv(nthreads),
             m_enabled(nthreads),
-            m_tasks(nthreads),
-            m_pool(nthreads) {
+            m_pool(nthreads),
+            m_tasks(nthreads) {
                 for (uint i = 0; i < nthreads; i++) 
                     m_enabled[i] = true;
                 for (uint i = 0; i < nthreads; i++) {
@@ -34,7 +34,7 @@ class ThreadPool final {
                     cpu_set_t cpuset;
                     CPU_ZERO(&cpuset);
                     CPU_SET(i, &cpuset);
-                    int rc = pthread_setaffinity_np(m_pool[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+                    pthread_setaffinity_np(m_pool[i].native_handle(), sizeof(cpu_set_t), &cpuset);
                 }
     
         }
@@ -2,6 +2,16 @@
 #define __UTILS_H
 
 #include <iostream>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Weight of the placeholder edge of the nodes without a minimum edge, heavier than any real edge
+#define MAX_WEIGHT std::numeric_limits<float>::infinity()
+
 /**
  * @brief Struct consisting in an Edge object
  * 
@@ -37,24 +47,157 @@ std::ostream& operator<<(std::ostream& os, const MyEdge& edge) {
 }
 
 
-float compute_MST(DisjointSets &initialComponents, Graph &graph) {
+/**
+ * @brief Edge together with its id: its position in the edge list of the loaded graph
+ *
+ * The edge lists of the rounds only hold the edges, their ids are kept apart (see EdgeIds) and read when an edge has
+ * to be traced back to the input (see mst.hpp). Edges carry their id where it cannot be looked up by position: as the
+ * minimum edge of a node, and in the lists that reorder the edges (the residual edges of a finish, Filter-Kruskal, the
+ * spill files of the out-of-core rounds).
+ */
+struct IdEdge : MyEdge {
+    uint id;
+};
+
+
+/**
+ * @brief Allocator leaving the elements added by a resize uninitialized
+ *
+ * A std::vector value-initializes the elements it adds, zero filling them. The scratch buffers of the rounds are
+ * written by the pass that sizes them before being read, so their resize only has to move the end of the buffer.
+ */
+template <typename T>
+struct uninitialized_allocator : std::allocator<T> {
 
-    std::vector<int> nodes;
+    template <typename U>
+    struct rebind { using other = uninitialized_allocator<U>; };
 
-    float weight = 0;
+    using std::allocator<T>::allocator;
 
-    for (int i = 0; i < initialComponents.mData.size(); i++) {
-        if (i != initialComponents.parent(i)) {
-            MyEdge edge = {i, initialComponents.parent(i), 10};
-            for (auto &_edge : graph.edges) {
-                if (_edge == edge) {
-                    weight += _edge.weight;
-                }
-            }
-        }
+    template <typename U>
+    void construct(U *p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new (static_cast<void *>(p)) U;
     }
 
-    return weight;
+    template <typename U, typename... Args>
+    void construct(U *p, Args&&... args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+};
+
+// Scratch edge list of the rounds, see uninitialized_allocator
+using EdgeBuffer = std::vector<MyEdge, uninitialized_allocator<MyEdge>>;
+
+// Ids of the edges of a scratch edge list, at the same positions
+using IdBuffer = std::vector<uint, uninitialized_allocator<uint>>;
+
+// Scratch list of edges carrying their ids
+using IdEdgeBuffer = std::vector<IdEdge, uninitialized_allocator<IdEdge>>;
+
+
+/**
+ * @brief Ids of the edges of a list, ids[i] being the id of edge i
+ *
+ * The loaded edges are their own ids, so these are not stored: an EdgeIds without an array reads i. The filters
+ * keep the order of the edges, and write the id of each survivor at its new position in an IdBuffer.
+ */
+class EdgeIds {
+
+    public:
+
+        EdgeIds(const uint *ids = nullptr) : ids(ids) {}
+
+        uint operator[](size_t i) const { return ids != nullptr ? ids[i] : static_cast<uint>(i); }
+
+    private:
+
+        const uint *ids;
+
+};
+
+
+/**
+ * @brief Read-only view of a contiguous array: the content of a vector, whatever its allocator, or a table of a mapped file
+ */
+template <typename T>
+class ArrayRef {
+
+    public:
+
+        ArrayRef() {}
+
+        ArrayRef(const T *first, size_t count) : first(first), count(count) {}
+
+        template <typename AllocT>
+        ArrayRef(const std::vector<T, AllocT> &vector) : first(vector.data()), count(vector.size()) {}
+
+        const T &operator[](size_t i) const { return first[i]; }
+
+        size_t size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        const T *data() const { return first; }
+
+        const T *begin() const { return first; }
+
+        const T *end() const { return first + count; }
+
+    private:
+
+        const T *first = nullptr;
+
+        size_t count = 0;
+
+};
+
+
+/**
+ * @brief Compare two edges in the total order of the minimum edge selection
+ * 
+ * Lighter edges win, ties go to the lowest id. Ids are the positions in the loaded edge list, sorted by
+ * (from, to), so the order is (weight, higher endpoint, lower endpoint) on the loaded graph, whatever the
+ * relabelings. Since no two edges compare equal the minimum spanning forest is unique: the minimum edge
+ * of a node does not depend on the order in which its edges are scanned, the minimum edges never close a
+ * cycle (except the 2-cycles of the nodes picking the same edge) and every engine, on any number of
+ * workers, finds the same forest.
+ */
+inline bool lighter(const IdEdge &a, const IdEdge &b) {
+    return a.weight < b.weight || (a.weight == b.weight && a.id < b.id);
+}
+
+
+/**
+ * @brief Offer an undirected edge as minimum edge of both its endpoints
+ * 
+ * @param minima minimum edge of each node, indexed by node id
+ * @param edge the edge, stored once for both directions
+ */
+inline void offer_edge(std::vector<IdEdge> &minima, const IdEdge &edge) {
+
+    IdEdge forward = edge;
+    IdEdge backward = {edge.to, edge.from, edge.weight, edge.id};
+
+    if (lighter(forward, minima[edge.from]))
+        minima[edge.from] = forward;
+
+    if (lighter(backward, minima[edge.to]))
+        minima[edge.to] = backward;
+
+}
+
+
+/**
+ * @brief Offer edge i of a list as minimum edge of both its endpoints
+ * 
+ * @param ids the ids of the list: the id of the edge is only loaded when the edge is at least as light as one of
+ *        the two minima, which few edges are once the first ones have been offered
+ */
+inline void offer_edge(std::vector<IdEdge> &minima, const MyEdge &edge, EdgeIds ids, size_t i) {
+
+    if (edge.weight <= minima[edge.from].weight || edge.weight <= minima[edge.to].weight)
+        offer_edge(minima, IdEdge{edge, ids[i]});
 
 }
 
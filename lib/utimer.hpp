@@ -1,3 +1,6 @@
+#if !defined(__UTIMER_H)
+#define __UTIMER_H
+
 #include <iostream>
 #include <chrono>
 
@@ -58,4 +61,6 @@ class Utimer {
 
         }
 
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,109 @@
+#!/bin/sh
+# Checks the number of edges and the weight of the spanning forest found by every version, engine and mode
+# against a Kruskal computed here, on the small graph test/graph.txt and on a random graph large enough
+# for the out-of-core rounds. Run it from the root of the repository after make (or with make check).
+
+cd "$(dirname "$0")/.." || exit 1
+
+BUILD=build
+WORKERS=3
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+
+# Kruskal on a "from to weight" file, printed as the "mst:" line of the drivers
+kruskal() {
+    grep -v '^[#%]' "$1" | sort -g -k3,3 | awk '
+        function find(x) { while ((x in parent) && parent[x] != x) x = parent[x]; return x }
+        {
+            a = find($1); b = find($2)
+            if (a == b) next
+            if (rank[a] < rank[b]) { t = a; a = b; b = t }
+            parent[b] = a
+            if (rank[a] == rank[b]) rank[a]++
+            edges++; weight += $3
+        }
+        END { printf "mst: %d edges, weight %.6f\n", edges, weight }'
+}
+
+# The given lines repeated once per worker count, as printed by the parallel drivers
+repeat() {
+    i=0
+    while [ $i -lt $WORKERS ]; do printf '%s\n' "$@"; i=$((i + 1)); done
+}
+
+# Runs a driver and compares the "mst:" lines it prints with $expected
+run() {
+    got=$("$@" 2>&1 | grep -o '^mst: [0-9]* edges, weight [0-9.]*')
+    if [ "$got" = "$expected" ]; then
+        echo "ok    $*"
+    else
+        echo "FAIL  $*"
+        failed=1
+    fi
+}
+
+# Runs every engine and mode of the three drivers on the given file
+run_all() {
+    file=$1
+    forest=$(kruskal "$2")
+
+    expected=$forest
+    run $BUILD/boruvka_sequential 0 0 "$file" 1
+    run $BUILD/boruvka_sequential 0 0 "$file" 1 engine=filterkruskal
+
+    expected=$(repeat "$forest")
+    for mode in "" min=atomic engine=filterkruskal; do
+        run $BUILD/boruvka_ff $WORKERS 0 0 "$file" 1 $mode
+    done
+
+    for mode in "" compress=1 csr=1 "csr=1 simd=scalar" "csr=1 contract=stars" layout=soa "layout=soa simd=scalar" \
+                fused=1 min=atomic contract=stars engine=filterkruskal finish=auto finish_nodes=4 pipeline=1; do
+        run $BUILD/boruvka_thread $WORKERS 0 0 "$file" 1 $mode
+    done
+}
+
+# Small graph: ties, two components and an unused node id
+GRAPH=test/graph.txt
+run_all $GRAPH $GRAPH
+
+$BUILD/boruvka_sequential 0 0 $GRAPH 1 save="$TMP/graph.snap" > /dev/null
+run_all "$TMP/graph.snap" $GRAPH
+
+# Insertion: the forest of the first half updated with the second half
+head -n 15 $GRAPH > "$TMP/first.txt"
+tail -n +16 $GRAPH > "$TMP/second.txt"
+expected=$(repeat "$(kruskal "$TMP/first.txt")" "$(kruskal $GRAPH)")
+run $BUILD/boruvka_thread $WORKERS 0 0 "$TMP/first.txt" 1 insert="$TMP/second.txt"
+
+# Streaming: a window covering the whole stream
+awk '{ print $1, $2, $3, NR }' $GRAPH > "$TMP/stream.txt"
+expected=$(repeat "$(kruskal $GRAPH)")
+run $BUILD/boruvka_thread $WORKERS 0 0 "$TMP/stream.txt" 1 window=100 slide=4
+
+# Random graph of 200000 distinct edges with integer weights, whose 2.4 MB do not fit in memory=1
+awk 'BEGIN {
+    srand(1)
+    while (edges < 200000) {
+        a = int(rand() * 20000); b = int(rand() * 20000)
+        if (a == b || (a " " b) in seen || (b " " a) in seen) continue
+        seen[a " " b] = 1
+        print a, b, 1 + int(rand() * 1000)
+        edges++
+    }
+}' > "$TMP/random.txt"
+
+$BUILD/boruvka_sequential 0 0 "$TMP/random.txt" 1 save="$TMP/random.snap" > /dev/null
+run_all "$TMP/random.snap" "$TMP/random.txt"
+
+expected=$(repeat "$(kruskal "$TMP/random.txt")")
+run $BUILD/boruvka_thread $WORKERS 0 0 "$TMP/random.snap" 1 memory=1 spill="$TMP"
+run $BUILD/boruvka_thread $WORKERS 0 0 "$TMP/random.snap" 1 memory=1 compress=1 spill="$TMP"
+
+if [ $failed -ne 0 ]; then
+    echo "some forests differ from Kruskal"
+    exit 1
+fi
+
+echo "all forests match Kruskal"